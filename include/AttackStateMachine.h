@@ -0,0 +1,569 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "KeyBindings.h"
+#include "PlayerCombatSnapshot.h"
+#include "Profiling.h"
+
+// Engine independent decision logic: takes plain button inputs and the player's combat state and emits the attacks to perform
+
+enum class InputDevice : std::uint8_t
+{
+    kKeyboard,
+    kMouse,
+    kGamepad
+};
+
+// A button event translated to the unified keycode space, with the same semantics as RE::ButtonEvent
+struct ButtonInput
+{
+    InputDevice device = InputDevice::kKeyboard;
+    std::uint32_t keycode = 0;
+    float value = 0.0f;
+    float heldDownSecs = 0.0f;
+    std::uint8_t attackHands = kHandNone;  // Game attack keys (right and/or left) mapped to this button
+
+    bool IsPressed() const { return value > 0.0f; }
+    bool IsDown() const { return IsPressed() && heldDownSecs == 0.0f; }
+    bool IsHeld() const { return IsPressed() && heldDownSecs > 0.0f; }
+    bool IsUp() const { return value == 0.0f && heldDownSecs > 0.0f; }
+};
+
+struct AttackConfig
+{
+    bool holdConsecutivePA = false;
+    bool holdConsecutiveLA = false;
+    float consecutiveAttacksDelay = 0.5f;
+    bool consecutiveDualAttacks = false;
+    bool usingMCO = false;
+
+    bool requireStaminaPA = false;
+    int staminaCost1H = 15;
+    int staminaCost2H = 30;
+
+    float inputBufferWindow = 0.0f;  // Seconds a rejected power attack press is kept for a retry, 0 disables it
+    float sequenceWindow = 0.3f;     // Max seconds between the presses of a tap sequence
+};
+
+struct InputBufferStats
+{
+    std::uint32_t hits = 0;     // Buffered presses performed on a retry
+    std::uint32_t expired = 0;  // Buffered presses dropped after the window
+};
+
+enum class AttackType : std::uint8_t
+{
+    kLight,
+    kPower
+};
+
+struct AttackAction
+{
+    std::uint8_t hand = kHandNone;  // kHandRight, kHandLeft or kHandBoth
+    AttackType type = AttackType::kLight;
+    std::uint8_t directions = 0;  // KeyBindingTable::GetDirections index of a power attack, resolved when it is performed
+};
+
+// Tables keyed by hand x attack type
+inline constexpr std::size_t kActionSlots = 6;
+
+constexpr std::size_t GetActionSlot(const AttackAction& action)
+{
+    const std::size_t attackType = action.type == AttackType::kPower ? 1 : 0;
+    switch (action.hand) {
+        case kHandRight: return 0 + attackType;
+        case kHandLeft: return 2 + attackType;
+        case kHandBoth: return 4 + attackType;
+        default: return kActionSlots;
+    }
+}
+
+// Attack window annotations of the player's animation graph, the window tags come from MCO
+enum class AttackWindowEvent : std::uint8_t
+{
+    kSwing,
+    kLightWindowOpen,
+    kLightWindowClose,
+    kPowerWindowOpen,
+    kPowerWindowClose,
+    kAttackStop
+};
+
+// What a decision was based on, only used for statistics
+enum class AttackOutcome : std::uint8_t
+{
+    kNone,
+    kComboPowerAttack,     // Power attack key with its combo key held
+    kPowerAttack,          // Power attack key without combo
+    kRepeatPowerAttack,
+    kRepeatLightAttack,
+    kBufferedPowerAttack,
+    kStaminaRejected,
+    kStateRejected,        // Power attack key pressed while the player cannot attack
+    kMenuRejected,         // Set by the game adapter, decisions are skipped while a menu blocks attacks
+    kCount
+};
+
+// Actions decided for a single input, in the order they have to be performed
+struct ActionList
+{
+    std::array<AttackAction, 4> actions{};
+    std::uint8_t count = 0;
+    bool staminaRejected = false;
+    AttackOutcome outcome = AttackOutcome::kNone;
+
+    void Push(std::uint8_t hand, AttackType type)
+    {
+        if (count < actions.size()) actions[count++] = { hand, type };
+    }
+
+    void Push(std::uint8_t hand, AttackType type, AttackOutcome reason)
+    {
+        Push(hand, type);
+        outcome = reason;
+    }
+
+    // Power attacks pushed since first take the direction table of the binding that decided them
+    void SetDirections(std::uint8_t first, std::uint8_t directions)
+    {
+        for (std::uint8_t i = first; i < count; ++i) {
+            if (actions[i].type == AttackType::kPower) actions[i].directions = directions;
+        }
+    }
+
+    const AttackAction* begin() const { return actions.data(); }
+    const AttackAction* end() const { return actions.data() + count; }
+    bool empty() const { return count == 0; }
+};
+
+// Time given to Process and Tick is in seconds from any fixed origin
+class AttackStateMachine
+{
+    public:
+        // Key state that has to be tracked even while attacks are not possible (menus, etc.)
+        void UpdateKeyState(const ButtonInput& input, const KeyBindingTable& bindings)
+        {
+            const auto& binding = bindings.Get(input.keycode);
+            if (binding.IsChordKey()) {
+                if (input.IsPressed()) heldChord |= binding.chordBit;
+                else heldChord &= ~binding.chordBit;
+            }
+
+            if (input.attackHands & kHandRight) rightHandKeyPressed = input.IsPressed();
+            if (input.attackHands & kHandLeft) leftHandKeyPressed = input.IsPressed();
+
+            // Releasing the key drops its pending repeat
+            if (!input.IsPressed()) {
+                if (powerRepeat.armed && powerRepeat.keycode == input.keycode) powerRepeat.armed = false;
+                if (rightRepeat.armed && rightRepeat.keycode == input.keycode) rightRepeat.armed = false;
+                if (leftRepeat.armed && leftRepeat.keycode == input.keycode) leftRepeat.armed = false;
+                if (holdAttack.armed && holdAttack.keycode == input.keycode) {
+                    holdAttack.armed = false;
+                    // Released before its hold time, the press goes to the plainer profiles of the key on the next decision
+                    if (holdFallback) pressFallback = { true, input.keycode, 0.0, holdTaps };
+                }
+            }
+        }
+
+        // Returns true when the input was consumed, by a power attack or because attacking is not possible.
+        // Either way the caller goes on with the rest of the batch, so later releases still reach UpdateKeyState
+        bool Process(const ButtonInput& input, double now, const PlayerCombatSnapshot& state, const KeyBindingTable& bindings, const AttackConfig& config, ActionList& out)
+        {
+            PAK_ZONE("AttackStateMachine::Process");
+            const auto& binding = bindings.Get(input.keycode);
+            if (input.IsDown() && binding.IsPowerAttackKey()) {
+                tapStreak.Press(input.keycode, now, config.sequenceWindow);
+                // Another press of the key continues the sequence the fallback was waiting on
+                if (pressFallback.armed && pressFallback.keycode == input.keycode) pressFallback.armed = false;
+            }
+
+            // Check if player cannot do attacks
+            if (!state.canAttack) {
+                if (input.IsDown() && binding.IsPowerAttackKey()) {
+                    BufferPowerAttack(input.keycode, now, config);
+                    out.outcome = AttackOutcome::kStateRejected;
+                }
+                return true;
+            }
+            // Due after a hold released early, or a sequence broken by another key
+            if (pressFallback.IsDue(now) || (input.IsDown() && pressFallback.armed)) ResolvePressFallback(state, bindings, config, out);
+            if (!input.IsDown()) return false;
+
+            if (binding.IsPowerAttackKey()) {
+                // Holding the key keeps chaining power attacks while the player is attacking
+                if (config.holdConsecutivePA) powerRepeat.Arm(input.keycode, now + PowerRepeatDelay(state, config));
+                if (PowerAttackFromBinding(binding, bindings, state, config, out, &input, now)) return true;
+                if (out.staminaRejected) BufferPowerAttack(input.keycode, now, config);
+            }
+
+            // The game performs the first light attack itself, only the repeats are scheduled
+            if (config.holdConsecutiveLA) {
+                if (input.attackHands & kHandRight) rightRepeat.Arm(input.keycode, now + RepeatDelay(state.rightWeapon, config));
+                if (input.attackHands & kHandLeft) leftRepeat.Arm(input.keycode, now + RepeatDelay(state.leftWeapon, config));
+            }
+            return false;
+        }
+
+        // Keeps the last power attack press that could not be performed, also used when the game rejected the action
+        void BufferPowerAttack(std::uint32_t keycode, double now, const AttackConfig& config)
+        {
+            if (config.inputBufferWindow > 0.0f) bufferedAttack = { true, keycode, now };
+        }
+
+        // Called when the animation graph signals that attacking may be possible again
+        void RetryBuffered(const PlayerCombatSnapshot& state, const KeyBindingTable& bindings, const AttackConfig& config, ActionList& out)
+        {
+            if (!bufferedAttack.armed || !state.canAttack) return;
+            if (PowerAttackFromBinding(bindings.Get(bufferedAttack.keycode), bindings, state, config, out)) out.outcome = AttackOutcome::kBufferedPowerAttack;
+        }
+
+        // Result of performing the actions from RetryBuffered, a failed retry stays buffered until it expires
+        void ResolveBuffered(bool performed)
+        {
+            if (!performed || !bufferedAttack.armed) return;
+            bufferedAttack.armed = false;
+            ++bufferStats.hits;
+        }
+
+        bool HasPendingRepeats() const { return powerRepeat.armed || rightRepeat.armed || leftRepeat.armed || bufferedAttack.armed || holdAttack.armed || pressFallback.armed; }
+        const InputBufferStats& GetBufferStats() const { return bufferStats; }
+        // Time of the buffered press, only meaningful while one is buffered
+        double GetBufferedTime() const { return bufferedAttack.time; }
+
+        // Called once per frame, performs the repeats whose deadline has passed
+        void Tick(double now, const PlayerCombatSnapshot& state, const KeyBindingTable& bindings, const AttackConfig& config, ActionList& out)
+        {
+            PAK_ZONE("AttackStateMachine::Tick");
+            if (bufferedAttack.armed && now - bufferedAttack.time > config.inputBufferWindow) {
+                bufferedAttack.armed = false;
+                ++bufferStats.expired;
+            }
+
+            // A hold binding attacks on its own, it does not need an ongoing attack
+            if (holdAttack.IsDue(now)) {
+                holdAttack.armed = false;
+                const auto first = out.count;
+                if (state.canAttack && PowerAttackWithHands(holdHands, state, config, out)) {
+                    out.SetDirections(first, holdDirections);
+                    out.outcome = holdOutcome;
+                    return;
+                }
+                BufferPowerAttack(holdAttack.keycode, now, config);
+            }
+
+            if (pressFallback.IsDue(now)) {
+                const auto keycode = pressFallback.keycode;
+                if (state.canAttack && ResolvePressFallback(state, bindings, config, out)) return;
+                pressFallback.armed = false;
+                if (!state.canAttack || out.staminaRejected) BufferPowerAttack(keycode, now, config);
+            }
+
+            // Repeats only chain into an ongoing attack, overdue ones fire as soon as that is possible again
+            if (!state.canAttack || !state.isAttacking || state.isBlocking) return;
+
+            // Once the animations report windows, a due repeat also waits for its window
+            if (powerRepeat.IsDue(now) && (!attackWindow.tracked || attackWindow.powerOpen)) {
+                powerRepeat.Advance(now, PowerRepeatDelay(state, config));
+                if (PowerAttackFromBinding(bindings.Get(powerRepeat.keycode), bindings, state, config, out)) {
+                    out.outcome = AttackOutcome::kRepeatPowerAttack;
+                    return;
+                }
+            }
+
+            const bool lightWindow = !attackWindow.tracked || attackWindow.lightOpen;
+            LightRepeats(rightRepeat.IsDue(now) && lightWindow, leftRepeat.IsDue(now) && lightWindow, false, now, state, config, out);
+        }
+
+        // Called for each attack window annotation in order, an armed repeat fires on the window opening instead of waiting for its delay
+        void OnAttackWindow(AttackWindowEvent event, double now, const PlayerCombatSnapshot& state, const KeyBindingTable& bindings, const AttackConfig& config, ActionList& out)
+        {
+            switch (event) {
+                case AttackWindowEvent::kSwing:
+                    attackWindow.lightOpen = false;
+                    attackWindow.powerOpen = false;
+                    return;
+                case AttackWindowEvent::kLightWindowOpen:
+                    attackWindow.tracked = true;
+                    attackWindow.lightOpen = true;
+                    break;
+                case AttackWindowEvent::kLightWindowClose:
+                    attackWindow.lightOpen = false;
+                    return;
+                case AttackWindowEvent::kPowerWindowOpen:
+                    attackWindow.tracked = true;
+                    attackWindow.powerOpen = true;
+                    break;
+                case AttackWindowEvent::kPowerWindowClose:
+                    attackWindow.powerOpen = false;
+                    return;
+                case AttackWindowEvent::kAttackStop:
+                    attackWindow = {};
+                    return;
+            }
+
+            if (!state.canAttack || state.isBlocking) return;
+            if (event == AttackWindowEvent::kPowerWindowOpen) {
+                if (powerRepeat.armed && PowerAttackFromBinding(bindings.Get(powerRepeat.keycode), bindings, state, config, out)) {
+                    powerRepeat.deadline = now + PowerRepeatDelay(state, config);
+                    out.outcome = AttackOutcome::kRepeatPowerAttack;
+                }
+                return;
+            }
+            LightRepeats(rightRepeat.armed, leftRepeat.armed, true, now, state, config, out);
+        }
+
+    private:
+        // Press whose binding is decided later, once a hold was released early or a tap sequence was not completed
+        struct PressFallback
+        {
+            bool armed = false;
+            std::uint32_t keycode = 0;
+            double deadline = 0.0;
+            std::uint32_t taps = 0;  // Presses before the deferred one
+
+            bool IsDue(double now) const { return armed && now >= deadline; }
+        };
+
+        // A repeat fired by its window restarts its delay from now, a timed one keeps its cadence
+        void LightRepeats(bool rightDue, bool leftDue, bool fromWindow, double now, const PlayerCombatSnapshot& state, const AttackConfig& config, ActionList& out)
+        {
+            auto reschedule = [&](RepeatTimer& timer, const WeaponProfile& weapon) {
+                const float delay = RepeatDelay(weapon, config);
+                if (fromWindow) timer.deadline = now + delay;
+                else timer.Advance(now, delay);
+            };
+
+            if (rightHandKeyPressed && leftHandKeyPressed && config.consecutiveDualAttacks && rightRepeat.armed && leftRepeat.armed) {
+                if (rightDue || leftDue) {
+                    reschedule(rightRepeat, state.rightWeapon);
+                    leftRepeat.deadline = rightRepeat.deadline;
+                    if (state.isLeftHandEquiped && state.isRightHandEquiped) out.Push(kHandBoth, AttackType::kLight, AttackOutcome::kRepeatLightAttack);
+                }
+                return;
+            }
+            if (rightDue) {
+                reschedule(rightRepeat, state.rightWeapon);
+                if (state.isRightHandEquiped) out.Push(kHandRight, AttackType::kLight, AttackOutcome::kRepeatLightAttack);
+            }
+            if (leftDue) {
+                reschedule(leftRepeat, state.leftWeapon);
+                if (state.isLeftHandEquiped) out.Push(kHandLeft, AttackType::kLight, AttackOutcome::kRepeatLightAttack);
+            }
+        }
+
+        // A press arms the hold bindings and waits for the rest of a tap sequence before trying the plainer bindings of its key,
+        // they attack right away when repeated or retried. A fallback decides the press again once the hold or sequence fell through
+        bool PowerAttackFromBinding(const KeyBinding& binding, const KeyBindingTable& bindings, const PlayerCombatSnapshot& state, const AttackConfig& config,
+                                    ActionList& out, const ButtonInput* press = nullptr, double now = 0.0, const PressFallback* fallback = nullptr)
+        {
+            bool chordMatched = false;
+            const auto taps = fallback ? fallback->taps : tapStreak.count;
+
+            // Candidates are sorted by specificity, chords take priority
+            const auto candidates = bindings.GetCandidates(binding);
+            for (std::size_t i = 0; i < candidates.size(); ++i) {
+                const auto& candidate = candidates[i];
+                if (candidate.chordMask) {
+                    if (candidate.chordMask != heldChord) continue;
+                } else if (chordMatched) {
+                    // The key is part of a held chord, profiles without chord are ignored
+                    return false;
+                }
+                if (fallback && candidate.holdTime > 0.0f) continue;
+                if (taps < candidate.taps) {
+                    // The sequence can still be completed, the plainer bindings wait for the sequence window
+                    if (press && HasPlainerCandidate(candidates.subspan(i + 1), taps)) {
+                        pressFallback = { true, press->keycode, now + config.sequenceWindow, taps };
+                        return true;
+                    }
+                    continue;
+                }
+
+                const auto outcome = candidate.chordMask ? AttackOutcome::kComboPowerAttack : AttackOutcome::kPowerAttack;
+                if (press && candidate.holdTime > 0.0f) {
+                    holdAttack.Arm(press->keycode, now + candidate.holdTime);
+                    holdHands = candidate.hands;
+                    holdOutcome = outcome;
+                    holdDirections = candidate.directions;
+                    holdTaps = taps;
+                    holdFallback = HasPlainerCandidate(candidates.subspan(i + 1), taps);
+                    if (candidate.taps) tapStreak.Reset();
+                    return true;
+                }
+                const auto first = out.count;
+                if (PowerAttackWithHands(candidate.hands, state, config, out)) {
+                    out.SetDirections(first, candidate.directions);
+                    out.outcome = outcome;
+                    if (candidate.taps) tapStreak.Reset();
+                    return true;
+                }
+                if (candidate.chordMask) chordMatched = true;
+            }
+            return false;
+        }
+
+        // A binding a press could still fall back to, chords are checked once the fallback is decided
+        static bool HasPlainerCandidate(std::span<const BindingCandidate> candidates, std::uint32_t taps)
+        {
+            return std::ranges::any_of(candidates, [&](const auto& candidate) { return candidate.holdTime <= 0.0f && candidate.taps <= taps; });
+        }
+
+        bool ResolvePressFallback(const PlayerCombatSnapshot& state, const KeyBindingTable& bindings, const AttackConfig& config, ActionList& out)
+        {
+            const auto fallback = pressFallback;
+            pressFallback.armed = false;
+            return PowerAttackFromBinding(bindings.Get(fallback.keycode), bindings, state, config, out, nullptr, 0.0, &fallback);
+        }
+
+        // Depending of the pressed keys, check for equiped weapon to trigger action
+        static bool PowerAttackWithHands(std::uint8_t hands, const PlayerCombatSnapshot& state, const AttackConfig& config, ActionList& out)
+        {
+            const bool isLeftHandAllowed = state.isLeftHandEquiped && (!state.isLeftHandUnarmed || state.isRightHandUnarmed);
+            if ((hands & kHandRight) && state.isRightHandEquiped) return PowerAttack(kHandRight, state, config, out);
+            if ((hands & kHandLeft) && isLeftHandAllowed) return PowerAttack(kHandLeft, state, config, out);
+            if (hands & kHandBoth) return PowerAttack(kHandBoth, state, config, out);
+            return false;
+        }
+
+        static bool PowerAttack(std::uint8_t hand, const PlayerCombatSnapshot& state, const AttackConfig& config, ActionList& out)
+        {
+            if (!HasEnoughStamina(hand, state, config)) {
+                out.staminaRejected = true;
+                out.outcome = AttackOutcome::kStaminaRejected;
+                return false;
+            }
+
+            bool lightAttackFirst = false;
+            switch (hand) {
+                case kHandRight:
+                    lightAttackFirst = (state.isRightHandUnarmed || state.inJumpState) && !config.usingMCO;
+                    break;
+                case kHandLeft: {
+                    const bool bothHandsWeaponsEquiped = state.isRightHandEquiped && state.isLeftHandEquiped && !(state.isRightHandUnarmed || state.isLeftHandUnarmed);
+                    const bool bothHandsUnarmed = state.isRightHandUnarmed && state.isLeftHandUnarmed;
+                    lightAttackFirst = !(config.usingMCO && (bothHandsWeaponsEquiped || bothHandsUnarmed));
+                    break;
+                }
+                default:
+                    lightAttackFirst = state.inJumpState;
+                    break;
+            }
+
+            const auto& weapon = hand == kHandLeft ? state.leftWeapon : state.rightWeapon;
+            if (weapon.lightAttackFirst >= 0) lightAttackFirst = weapon.lightAttackFirst != 0;
+
+            if (lightAttackFirst) out.Push(hand, AttackType::kLight);
+            out.Push(hand, AttackType::kPower);
+            return true;
+        }
+
+        static bool HasEnoughStamina(std::uint8_t hand, const PlayerCombatSnapshot& state, const AttackConfig& config)
+        {
+            PAK_ZONE("HasEnoughStamina");
+            if (!config.requireStaminaPA) return true;
+            auto handCost = [&](const WeaponProfile& weapon, bool twoHanded) {
+                if (weapon.staminaCost >= 0) return weapon.staminaCost;
+                return twoHanded ? config.staminaCost2H : config.staminaCost1H;
+            };
+
+            int staminaCost = 0;
+            if (hand == kHandBoth) staminaCost = handCost(state.rightWeapon, false) + handCost(state.leftWeapon, false);
+            else if (hand == kHandRight) staminaCost = handCost(state.rightWeapon, state.hasTwoHandedWeapon);
+            else staminaCost = handCost(state.leftWeapon, false);
+            return state.stamina >= staminaCost;
+        }
+
+        static float RepeatDelay(const WeaponProfile& weapon, const AttackConfig& config)
+        {
+            return weapon.repeatDelay >= 0.0f ? weapon.repeatDelay : config.consecutiveAttacksDelay;
+        }
+
+        // Follows the weapon that power attacks first, see PowerAttackWithHands
+        static float PowerRepeatDelay(const PlayerCombatSnapshot& state, const AttackConfig& config)
+        {
+            return RepeatDelay(state.isRightHandEquiped ? state.rightWeapon : state.leftWeapon, config);
+        }
+
+        struct RepeatTimer
+        {
+            bool armed = false;
+            std::uint32_t keycode = 0;  // Key that has to stay held
+            double deadline = 0.0;
+
+            void Arm(std::uint32_t key, double at)
+            {
+                armed = true;
+                keycode = key;
+                deadline = at;
+            }
+
+            bool IsDue(double now) const { return armed && now >= deadline; }
+
+            // Keeps a fixed cadence, but never schedules a burst to catch up after a stall
+            void Advance(double now, float delay)
+            {
+                deadline += delay;
+                if (deadline <= now) deadline = now + delay;
+            }
+        };
+
+        // Presses of the same power attack key in quick succession
+        struct TapStreak
+        {
+            std::uint32_t keycode = kKeycodeCount;
+            std::uint32_t count = 0;  // Presses before the last one
+            double lastPress = 0.0;
+
+            void Press(std::uint32_t key, double now, float window)
+            {
+                count = key == keycode && now - lastPress <= window ? count + 1 : 0;
+                keycode = key;
+                lastPress = now;
+            }
+
+            void Reset() { keycode = kKeycodeCount; }
+        };
+
+        std::uint32_t heldChord = 0;  // Chord bits of the keys being held
+        TapStreak tapStreak;
+
+        bool rightHandKeyPressed = false;
+        bool leftHandKeyPressed = false;
+
+        struct BufferedAttack
+        {
+            bool armed = false;
+            std::uint32_t keycode = 0;
+            double time = 0.0;
+        };
+
+        RepeatTimer powerRepeat;
+        RepeatTimer rightRepeat;
+        RepeatTimer leftRepeat;
+
+        // Attack windows reported by the animations, untracked until a window tag was seen during the attack
+        struct AttackWindowState
+        {
+            bool tracked = false;
+            bool lightOpen = false;
+            bool powerOpen = false;
+        };
+
+        AttackWindowState attackWindow;
+
+        RepeatTimer holdAttack;
+        std::uint8_t holdHands = kHandNone;
+        AttackOutcome holdOutcome = AttackOutcome::kNone;
+        std::uint8_t holdDirections = 0;
+        std::uint32_t holdTaps = 0;
+        bool holdFallback = false;  // Plainer bindings take the press when the hold is released early
+
+        PressFallback pressFallback;
+
+        BufferedAttack bufferedAttack;
+        InputBufferStats bufferStats;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "AttackStateMachine.h"
+
+// Lock-free counters and timings of the input handling, only written to while enabled
+class AttackStats
+{
+    public:
+        enum class Timing : std::uint8_t
+        {
+            kBatch,   // Whole input event chain
+            kEvent,   // Single relevant button event, decision and queueing
+            kUpdate,  // Per-frame update with pending repeats
+            kDrain,   // Dispatch of the queued actions on the main thread
+            kCount
+        };
+
+        static AttackStats* GetSingleton();
+
+        bool IsEnabled() const { return enabled.load(std::memory_order_relaxed); }
+        void SetEnabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+
+        void RecordTiming(Timing timing, std::uint64_t ns);
+        void RecordOutcome(AttackOutcome outcome);
+        void RecordDispatchFailed();
+        // Queued decisions found by a drain, and the actions collapsed into an identical one
+        void RecordQueueDepth(std::size_t depth);
+        void RecordCollapsedActions(std::size_t count);
+        // Time from a key going down to its action being performed
+        void RecordLatency(std::uint64_t ns);
+
+        // Summary lines for the log or the console, optionally clearing every counter while reading it
+        std::vector<std::string> Summarize(bool reset);
+
+    private:
+        struct Accumulator
+        {
+            std::atomic<std::uint64_t> count = 0;
+            std::atomic<std::uint64_t> total = 0;
+            std::atomic<std::uint64_t> max = 0;
+
+            void Add(std::uint64_t value)
+            {
+                count.fetch_add(1, std::memory_order_relaxed);
+                total.fetch_add(value, std::memory_order_relaxed);
+                auto current = max.load(std::memory_order_relaxed);
+                while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+            }
+        };
+
+        // Upper bounds in microseconds, the last bucket holds everything above
+        static constexpr std::array<std::uint64_t, 15> latencyBucketsUs{ 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000 };
+
+        std::atomic<bool> enabled = false;
+        std::array<Accumulator, static_cast<std::size_t>(Timing::kCount)> timings;  // In nanoseconds
+        std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(AttackOutcome::kCount)> outcomes{};
+        std::atomic<std::uint64_t> dispatchFailed = 0;
+        std::atomic<std::uint64_t> collapsedActions = 0;
+        Accumulator queueDepth;
+        std::array<std::atomic<std::uint64_t>, latencyBucketsUs.size() + 1> latencyBuckets{};
+};
+
+// Adds the time spent until the end of the scope, does nothing while stats are disabled
+class ScopedTiming
+{
+    public:
+        explicit ScopedTiming(AttackStats::Timing timing) : timing(timing)
+        {
+            if (AttackStats::GetSingleton()->IsEnabled()) start = std::chrono::steady_clock::now();
+        }
+
+        ~ScopedTiming()
+        {
+            if (start == std::chrono::steady_clock::time_point{}) return;
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            AttackStats::GetSingleton()->RecordTiming(timing, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+
+        ScopedTiming(const ScopedTiming&) = delete;
+        ScopedTiming& operator=(const ScopedTiming&) = delete;
+
+    private:
+        AttackStats::Timing timing;
+        std::chrono::steady_clock::time_point start;
+};
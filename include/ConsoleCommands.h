@@ -0,0 +1,14 @@
+#pragma once
+
+namespace ConsoleCommands
+{
+    // PowerAttackStats (pakstats): prints the input handling statistics and resets them
+    struct PrintStats
+    {
+        static bool Execute(const RE::SCRIPT_PARAMETER* a_paramInfo, RE::SCRIPT_FUNCTION::ScriptData* a_scriptData, RE::TESObjectREFR* a_thisObj,
+                            RE::TESObjectREFR* a_containingObj, RE::Script* a_scriptObj, RE::ScriptLocals* a_locals, double& a_result,
+                            std::uint32_t& a_opcodeOffsetPtr);
+    };
+
+    void Register();
+}
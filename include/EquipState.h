@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// What a hand can do with the object it holds
+enum class HandClass : std::uint8_t
+{
+    kNone,        // Spell, shield, torch or anything that cannot melee attack
+    kUnarmed,     // Empty hand or hand to hand weapon
+    kOneHanded,
+    kTwoHanded,
+    kRanged,
+    kStaff
+};
+
+// Mirrors RE::WEAPON_TYPE so the classification can be built without CommonLibSSE
+enum class WeaponType : std::uint8_t
+{
+    kHandToHandMelee,
+    kOneHandSword,
+    kOneHandDagger,
+    kOneHandAxe,
+    kOneHandMace,
+    kTwoHandSword,
+    kTwoHandAxe,
+    kBow,
+    kStaff,
+    kCrossbow
+};
+
+inline constexpr std::size_t kWeaponTypeCount = 10;
+
+struct EquippedObject
+{
+    bool empty = true;
+    bool isWeapon = false;
+    WeaponType weaponType = WeaponType::kHandToHandMelee;
+    std::uint8_t profile = 0;  // Weapon profile resolved for this object
+};
+
+// Both hands packed together so the input handler reads them with a single load
+struct EquipState
+{
+    HandClass right = HandClass::kUnarmed;
+    HandClass left = HandClass::kUnarmed;
+    std::uint8_t rightProfile = 0;
+    std::uint8_t leftProfile = 0;
+    std::uint32_t profileVersion = 0;  // Version of the weapon profile lookup the profiles were resolved with
+};
+
+constexpr HandClass ClassifyObject(const EquippedObject& object)
+{
+    if (object.empty) return HandClass::kUnarmed;
+    if (!object.isWeapon) return HandClass::kNone;
+    switch (object.weaponType) {
+        case WeaponType::kHandToHandMelee:
+            return HandClass::kUnarmed;
+        case WeaponType::kTwoHandSword:
+        case WeaponType::kTwoHandAxe:
+            return HandClass::kTwoHanded;
+        case WeaponType::kBow:
+        case WeaponType::kCrossbow:
+            return HandClass::kRanged;
+        case WeaponType::kStaff:
+            return HandClass::kStaff;
+        default:
+            return HandClass::kOneHanded;
+    }
+}
+
+// Provider is anything with an `EquippedObject GetEquippedObject(bool leftHand) const`
+template <class Provider>
+constexpr EquipState ClassifyEquipment(const Provider& provider)
+{
+    EquipState state;
+    const auto right = provider.GetEquippedObject(false);
+    state.right = ClassifyObject(right);
+    state.rightProfile = right.profile;
+
+    // A two handed weapon takes the left hand as well
+    if (state.right == HandClass::kTwoHanded) {
+        state.left = HandClass::kNone;
+    } else {
+        const auto left = provider.GetEquippedObject(true);
+        state.left = ClassifyObject(left);
+        state.leftProfile = left.profile;
+    }
+    return state;
+}
+
+constexpr bool CanMeleeAttack(HandClass hand)
+{
+    return hand == HandClass::kUnarmed || hand == HandClass::kOneHanded || hand == HandClass::kTwoHanded;
+}
+
+constexpr bool IsUnarmed(HandClass hand)
+{
+    return hand == HandClass::kUnarmed;
+}
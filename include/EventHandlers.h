@@ -0,0 +1,54 @@
+#pragma once
+
+#include "EquipState.h"
+#include "SnapshotPublisher.h"
+
+struct SettingsSnapshot;
+
+// Weapon overrides of a settings snapshot mapped to forms, profile indices only mean something together with that snapshot
+struct WeaponProfileLookup
+{
+    const SettingsSnapshot* settings = nullptr;
+    std::uint32_t version = 0;
+
+    // Weapons matched by FormID or keyword, the others use the profile of their type
+    std::unordered_map<RE::FormID, std::uint8_t> profileByWeapon;
+    std::array<std::uint8_t, kWeaponTypeCount> profileByType{};
+
+    std::uint8_t GetProfile(const RE::TESForm* form) const;
+};
+
+// Keeps the classification of the player's hands up to date from equip events
+class EquipEventHandler : public RE::BSTEventSink<RE::TESEquipEvent>
+{
+    public:
+        static EquipEventHandler* GetSingleton();
+        RE::BSEventNotifyControl ProcessEvent(const RE::TESEquipEvent* a_event, RE::BSTEventSource<RE::TESEquipEvent>*) override;
+        // Refreshes run one after the other as main thread tasks, the last one always reads the latest equipment and lookup
+        void QueueRefresh();
+        EquipState GetState() const { return state.load(std::memory_order_acquire); }
+        // Maps the weapon overrides from the settings to forms, once data is loaded and after every settings reload,
+        // then queues a refresh of the equipment so its profiles follow the new lookup
+        void ResolveWeaponProfiles();
+        // Null until resolved, the state's profiles only apply while its profileVersion matches
+        const WeaponProfileLookup* GetWeaponProfiles() const { return weaponProfiles.Get(); }
+
+    private:
+        void Refresh();
+
+        std::atomic<EquipState> state;
+
+        // Built on the UI thread on reload while main thread tasks read it
+        SnapshotPublisher<WeaponProfileLookup> weaponProfiles;
+        std::atomic<std::uint32_t> lookupVersion = 0;
+};
+
+// Invalidates the cached player combat snapshot when the player's animation graph changes state,
+// and signals when a buffered power attack may be retried
+class AnimationEventHandler : public RE::BSTEventSink<RE::BSAnimationGraphEvent>
+{
+    public:
+        static AnimationEventHandler* GetSingleton();
+        RE::BSEventNotifyControl ProcessEvent(const RE::BSAnimationGraphEvent* a_event, RE::BSTEventSource<RE::BSAnimationGraphEvent>*) override;
+        void Register();
+};
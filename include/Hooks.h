@@ -0,0 +1,13 @@
+#pragma once
+
+namespace Hooks
+{
+    // PlayerCharacter::Update, gives the input handler a per-frame tick
+    struct PlayerUpdate
+    {
+        static void Update(RE::PlayerCharacter* a_this, float a_delta);
+        static inline REL::Relocation<decltype(Update)> _Update;
+    };
+
+    void Install();
+}
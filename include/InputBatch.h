@@ -0,0 +1,21 @@
+#pragma once
+
+#include <algorithm>
+#include <ranges>
+#include <vector>
+
+#include "AttackStateMachine.h"
+
+// Adds an input to the batch of an input event chain. Down and up edges are kept in order, the held events of a key
+// between them are folded into the latest one so a flood of held events costs a single decision
+inline void AppendInput(std::vector<ButtonInput>& batch, const ButtonInput& input)
+{
+    if (input.IsHeld()) {
+        const auto previous = std::ranges::find(batch | std::views::reverse, input.keycode, &ButtonInput::keycode);
+        if (previous != batch.rend() && previous->IsHeld()) {
+            *previous = input;
+            return;
+        }
+    }
+    batch.push_back(input);
+}
@@ -1,55 +1,103 @@
 #pragma once
 
+#include "AttackStateMachine.h"
+#include "SnapshotPublisher.h"
+#include "SpscRing.h"
+
+struct SettingsSnapshot;
+
+// Game side of the attack logic: translates input events for AttackStateMachine and performs the actions it decides
 class InputEventHandler : public RE::BSTEventSink<RE::InputEvent*>
 {
     public:
         static InputEventHandler* GetSingleton();
         RE::BSEventNotifyControl ProcessEvent(RE::InputEvent* const* a_event,RE::BSTEventSource<RE::InputEvent*>*) override;
-        void GetAttackKeys();
+        // Rebuilds the key map from the game's controls and the bound keys, published only if it changed
+        void RefreshAttackKeys();
+        // Movement keys released during a loading screen are never seen
+        void ResetMovement() { movementStale.store(true, std::memory_order_release); }
+        // Looks up the attack actions once data is loaded, returns false if any of them is missing
+        bool ResolveActions();
+        // Per-frame update from the main thread, which also dispatches the input events
+        void Update(RE::PlayerCharacter* player);
+        // Performs the actions queued by the input sink, from a main thread task
+        void DrainActions();
+        void SetMenuBlocking(bool blocking) { menuBlocking.store(blocking, std::memory_order_release); }
+        void InvalidateSnapshot() { snapshotDirty.store(true, std::memory_order_release); }
+        void SignalAttackAllowed() { attackAllowedSignal.store(true, std::memory_order_release); }
+        // Called from the animation graph's thread, the events are applied in order on the next update
+        void SignalAttackWindow(AttackWindowEvent event);
 
     private:
-        bool IsRightHandKey(const RE::INPUT_DEVICE device, const std::uint32_t key) const;
-        bool IsLeftHandKey(const RE::INPUT_DEVICE device, const std::uint32_t key) const;
-        bool PerformRightHandPA(RE::PlayerCharacter* player);
-        bool PerformLeftHandPA(RE::PlayerCharacter* player);
-        bool PerformBothHandsPA(RE::PlayerCharacter* player);
-
-        static void PerformAction(RE::BGSAction* action, RE::Actor* a);
-        static bool HasEquipedWeapon(const RE::PlayerCharacter* player, bool leftHand);
-        static bool IsHandUnarmed(const RE::PlayerCharacter* player, bool leftHand);
-        static bool HasEquippedTwoHandedWeapon(const RE::PlayerCharacter* player);
-        static bool HasEnoughStamina(RE::PlayerCharacter* player, bool rightHand, bool leftHand);
+        // Game controls in the unified keycode space, replaced as a whole so the input sink never sees half of a refresh
+        struct AttackKeyMap
+        {
+            std::bitset<kKeycodeCount> interestingKeys;  // Bound keys plus the game's attack keys, anything else is ignored right away
+            std::bitset<kKeycodeCount> rightHandKeys;
+            std::bitset<kKeycodeCount> leftHandKeys;
+            // Forward, back, strafe left and right, keyboard only since the gamepad moves with the stick
+            std::array<std::uint32_t, 4> movementKeysKeyboard{ 255, 255, 255, 255 };
+
+            bool operator==(const AttackKeyMap&) const = default;
+        };
+
+        struct QueuedDecision
+        {
+            ActionList actions;
+            std::uint32_t keycode = 0;                       // Key that decided the actions, buffered if the game rejects them
+            double time = 0.0;
+            std::chrono::steady_clock::time_point received;  // Only set while stats are enabled
+        };
+
+        void QueueActions(const QueuedDecision& decision);
+        void ApplyAttackWindows(RE::PlayerCharacter* player);
+        void CollectInputs(RE::InputEvent* event);
+        void TrackMovement(RE::InputEvent* event, const AttackKeyMap& keys);
+        const PlayerCombatSnapshot& GetSnapshot(RE::PlayerCharacter* player, const SettingsSnapshot& settings);
+        bool PerformActions(const ActionList& actions, RE::PlayerCharacter* player);
+        bool PerformAction(const AttackAction& action, RE::Actor* player);
+        RE::BGSAction* GetAction(const AttackAction& action) const;
+        RE::TESActionData* GetActionData(std::size_t slot);
+
+        static double GetTime();
         static void FlashHUDMeter(RE::ActorValue a_av);
 
-        RE::BGSAction* PARightHandAction = RE::TESForm::LookupByID(0x13383)->As<RE::BGSAction>();
-        RE::BGSAction* PALeftHandAction = RE::TESForm::LookupByID(0x2E2F6)->As<RE::BGSAction>();
-        RE::BGSAction* PABothHandsAction = RE::TESForm::LookupByID(0x2E2F7)->As<RE::BGSAction>();
-        RE::BGSAction* LARightHandAction = RE::TESForm::LookupByID(0x13005)->As<RE::BGSAction>();
-        RE::BGSAction* LALeftHandAction = RE::TESForm::LookupByID(0x13004)->As<RE::BGSAction>();
-        RE::BGSAction* LABothHandsAction = RE::TESForm::LookupByID(0x50C96)->As<RE::BGSAction>();
+        // Indexed by GetActionSlot
+        static constexpr std::array<RE::FormID, kActionSlots> actionFormIDs{
+            0x13005,  // ActionRightAttack
+            0x13383,  // ActionRightPowerAttack
+            0x13004,  // ActionLeftAttack
+            0x2E2F6,  // ActionLeftPowerAttack
+            0x50C96,  // ActionDualAttack
+            0x2E2F7   // ActionDualPowerAttack
+        };
+        std::array<RE::BGSAction*, kActionSlots> attackActions{};
 
-        std::uint32_t rightAttackKeyKeyboard = 255;
-        std::uint32_t rightAttackKeyMouse = 255;
-        std::uint32_t rightAttackKeyGamepad = 255;
+        // Reused between dispatches, one per action, reset from a freshly constructed copy before each one.
+        // Never freed: they live on the game's heap, which must not be touched from our static destructors at exit
+        std::array<RE::TESActionData*, kActionSlots> actionData{};
+        RE::TESActionData* actionDataDefaults = nullptr;
+        std::uint32_t actionDataAllocations = 0;
 
-        std::uint32_t leftAttackKeyKeyboard = 255;
-        std::uint32_t leftAttackKeyMouse = 255;
-        std::uint32_t leftAttackKeyGamepad = 255;
+        // Decisions from the input sink, drained once per frame so the sink never calls into the game's action code
+        SpscRing<QueuedDecision, 64> decisionQueue;
+        std::atomic<bool> drainScheduled = false;
 
-        bool comboActive = false;
-        bool comboActiveAlt1 = false;
-        bool comboActiveAlt2 = false;
+        // Refreshed from the UI and main threads, read once per batch by the input sink
+        SnapshotPublisher<AttackKeyMap> attackKeys;
 
-        bool rightHandKeyPressed = false;
-        bool leftHandKeyPressed = false;
+        MovementTracker movement;
+        std::atomic<bool> movementStale = false;
 
-        float rightAttackHeldTime = 0.0f;
-        bool rightAttackWaiting = false;
+        // Relevant inputs of the current batch, reused between batches
+        std::vector<ButtonInput> batchInputs;
+        std::atomic<bool> menuBlocking = false;
 
-        float leftAttackHeldTime = 0.0f;
-        bool leftAttackWaiting = false;
+        PlayerCombatSnapshot snapshot;
+        std::atomic<bool> snapshotDirty = true;
 
-        float powerAttackHeldTime = 0.0f;
-        bool powerAttackWaiting = false;
-        
-};
\ No newline at end of file
+        AttackStateMachine attackStateMachine;
+        std::atomic<bool> attackAllowedSignal = false;
+        SpscRing<AttackWindowEvent, 16> attackWindowEvents;
+        std::uint32_t expiredReported = 0;
+};
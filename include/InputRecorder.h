@@ -0,0 +1,30 @@
+#pragma once
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "InputRecording.h"
+#include "SpscRing.h"
+
+// Streams every decision to a binary file under the SKSE log directory, the input thread only pushes into a ring buffer
+class InputRecorder
+{
+    public:
+        static InputRecorder* GetSingleton();
+        ~InputRecorder();
+        void Start();
+        bool IsRecording() const { return ring != nullptr; }
+        void Record(double time, const ButtonInput& input, const PlayerCombatSnapshot& state, const ActionList& actions, std::uint16_t flags, std::uint32_t decisionNs);
+
+    private:
+        void FlushLoop(std::stop_token stopToken);
+        // Writes whatever the ring holds, only called by the thread that consumes it
+        void Drain();
+
+        std::unique_ptr<SpscRing<InputRecord, 4096>> ring;
+        std::atomic<std::uint32_t> droppedRecords = 0;
+        std::ofstream file;
+        std::jthread flushThread;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+#include "AttackStateMachine.h"
+
+// Binary format shared by the in-game recorder and the offline replay tool: a RecordingHeader, its BindingProfiles, then InputRecords
+
+inline constexpr std::uint32_t kRecordingMagic = 0x524B4150;  // "PAKR"
+inline constexpr std::uint32_t kRecordingVersion = 9;
+
+enum RecordFlags : std::uint16_t
+{
+    kRecordConsumed = 1 << 0,         // AttackStateMachine::Process returned true
+    kRecordStaminaRejected = 1 << 1,
+    kRecordMenuBlocked = 1 << 2,      // Behind a menu, only the key state was updated
+    kRecordTick = 1 << 3,             // Per-frame update of the hold repeats, the input is unused
+    kRecordRetry = 1 << 4,            // Tick that also retried the buffered power attack
+    kRecordDispatchFailed = 1 << 5,   // The game rejected the power attack action
+    kRecordDispatch = 1 << 6,         // Queued actions performed on the main thread, the input only holds the deciding key
+    kRecordWindow = 1 << 7,           // Attack window annotation, the input keycode holds the AttackWindowEvent
+    kRecordNotReady = 1 << 8          // Player not loaded or movement controls disabled, only the key state was updated
+};
+
+struct RecordingHeader
+{
+    std::uint32_t magic = kRecordingMagic;
+    std::uint32_t version = kRecordingVersion;
+    AttackConfig config;
+    std::uint32_t profileCount = 0;
+};
+
+struct InputRecord
+{
+    double time = 0.0;              // Clock given to AttackStateMachine, in seconds
+    ButtonInput input;
+    PlayerCombatSnapshot state;
+    std::uint32_t decisionNs = 0;   // Time spent deciding on this input
+    std::uint16_t flags = 0;
+    std::uint8_t actionCount = 0;
+    std::array<AttackAction, 4> actions{};
+};
+
+// Written as raw bytes, so the layout has to match between the game build and the replay tool
+static_assert(std::is_trivially_copyable_v<RecordingHeader> && sizeof(RecordingHeader) == 40);
+static_assert(std::is_trivially_copyable_v<BindingProfile> && sizeof(BindingProfile) == 44);
+static_assert(std::is_trivially_copyable_v<InputRecord> && sizeof(InputRecord) == 88);
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "MoveDirection.h"
+
+// Unified keycode space used by the settings: keyboard 0-255, mouse 256-265, gamepad 266-281 (SKSE::InputMap)
+inline constexpr std::uint32_t kKeycodeCount = 282;
+
+// Keys a single profile can require to be held together with its attack keys
+inline constexpr std::size_t kMaxChordKeys = 4;
+// Distinct chord keys over all the profiles, one bit each in the held chord mask
+inline constexpr std::size_t kMaxChordMaskKeys = 32;
+
+enum HandMask : std::uint8_t
+{
+    kHandNone = 0,
+    kHandRight = 1 << 0,
+    kHandLeft = 1 << 1,
+    kHandBoth = 1 << 2
+};
+
+// A set of attack keys as read from the INI, -1 means unbound
+struct BindingProfile
+{
+    int rightHandKey = -1;
+    int leftHandKey = -1;
+    int bothHandsKey = -1;
+    std::array<int, kMaxChordKeys> chordKeys{ -1, -1, -1, -1 };  // Exactly these chord keys have to be held, none means any
+    std::uint32_t taps = 0;                                      // Quick presses of the same key before the one that attacks
+    float holdTime = 0.0f;                                       // Attack once the key was held this long instead of on press
+    DirectionTable directions{};                                 // Indexed by the movement direction, all neutral leaves the direction alone
+};
+
+// A profile compiled for one of its keys, candidates sharing the same conditions are merged
+struct BindingCandidate
+{
+    std::uint32_t chordMask = 0;
+    std::uint8_t hands = kHandNone;
+    std::uint8_t taps = 0;
+    float holdTime = 0.0f;
+    std::uint8_t directions = 0;  // KeyBindingTable::GetDirections index
+
+    bool SameConditions(const BindingCandidate& other) const
+    {
+        return chordMask == other.chordMask && taps == other.taps && holdTime == other.holdTime && directions == other.directions;
+    }
+
+    // More specific candidates are tried first
+    bool IsMoreSpecific(const BindingCandidate& other) const
+    {
+        const int chordKeys = std::popcount(chordMask);
+        const int otherChordKeys = std::popcount(other.chordMask);
+        if (chordKeys != otherChordKeys) return chordKeys > otherChordKeys;
+        if (taps != other.taps) return taps > other.taps;
+        return holdTime > other.holdTime;
+    }
+};
+
+struct KeyBinding
+{
+    std::uint32_t chordBit = 0;         // Bit of this key in the held chord mask, 0 if no profile uses it in a chord
+    std::uint16_t firstCandidate = 0;
+    std::uint16_t candidateCount = 0;
+
+    bool IsPowerAttackKey() const { return candidateCount != 0; }
+    bool IsChordKey() const { return chordBit != 0; }
+};
+
+// Keycode -> binding lookup built from the profiles, an input event costs an indexed load plus the candidates of its own key
+// no matter how many profiles are defined
+class KeyBindingTable
+{
+    public:
+        // Returns false when profiles were skipped because they used more than kMaxChordMaskKeys distinct chord keys
+        bool Build(std::span<const BindingProfile> profiles)
+        {
+            table.fill({});
+            boundKeys.reset();
+            candidates.clear();
+            directionTables.assign(1, DirectionTable{});
+
+            bool allBuilt = true;
+            std::array<std::vector<BindingCandidate>, kKeycodeCount> keyCandidates;
+            std::uint32_t nextChordBit = 1;
+
+            for (const auto& profile : profiles) {
+                BindingCandidate candidate;
+                candidate.taps = static_cast<std::uint8_t>(std::min<std::uint32_t>(profile.taps, 255));
+                candidate.holdTime = std::max(profile.holdTime, 0.0f);
+                candidate.directions = AddDirections(profile.directions);
+
+                bool chordBuilt = true;
+                for (const int key : profile.chordKeys) {
+                    if (key <= 0 || key >= static_cast<int>(kKeycodeCount)) continue;
+                    auto& entry = table[key];
+                    if (!entry.chordBit) {
+                        if (!nextChordBit) {
+                            chordBuilt = false;
+                            break;
+                        }
+                        entry.chordBit = nextChordBit;
+                        nextChordBit <<= 1;
+                        boundKeys.set(key);
+                    }
+                    candidate.chordMask |= entry.chordBit;
+                }
+                if (!chordBuilt) {
+                    allBuilt = false;
+                    continue;
+                }
+
+                auto bind = [&](int key, std::uint8_t hand) {
+                    if (key < 0 || key >= static_cast<int>(kKeycodeCount)) return;
+                    auto& list = keyCandidates[key];
+                    const auto existing = std::ranges::find_if(list, [&](const auto& other) { return other.SameConditions(candidate); });
+                    if (existing != list.end()) {
+                        existing->hands |= hand;
+                    } else {
+                        list.push_back(candidate);
+                        list.back().hands = hand;
+                    }
+                    boundKeys.set(key);
+                };
+                bind(profile.rightHandKey, kHandRight);
+                bind(profile.leftHandKey, kHandLeft);
+                bind(profile.bothHandsKey, kHandBoth);
+            }
+
+            // Flattened so the candidates of a key are contiguous
+            for (std::uint32_t key = 0; key < kKeycodeCount; ++key) {
+                auto& list = keyCandidates[key];
+                if (list.empty()) continue;
+                std::ranges::stable_sort(list, [](const auto& a, const auto& b) { return a.IsMoreSpecific(b); });
+                table[key].firstCandidate = static_cast<std::uint16_t>(candidates.size());
+                table[key].candidateCount = static_cast<std::uint16_t>(list.size());
+                candidates.insert(candidates.end(), list.begin(), list.end());
+            }
+            return allBuilt;
+        }
+
+        const KeyBinding& Get(std::uint32_t keycode) const
+        {
+            return keycode < kKeycodeCount ? table[keycode] : unbound;
+        }
+
+        // Most specific first
+        std::span<const BindingCandidate> GetCandidates(const KeyBinding& binding) const
+        {
+            return std::span(candidates).subspan(binding.firstCandidate, binding.candidateCount);
+        }
+
+        // Table 0 never changes the direction
+        const DirectionTable& GetDirections(std::uint8_t index) const
+        {
+            return index < directionTables.size() ? directionTables[index] : directionTables.front();
+        }
+
+        // Power attack and chord keys
+        const std::bitset<kKeycodeCount>& GetBoundKeys() const { return boundKeys; }
+
+    private:
+        // Profiles with the same table share it, past the last index they keep the direction
+        std::uint8_t AddDirections(const DirectionTable& directions)
+        {
+            const auto existing = std::ranges::find(directionTables, directions);
+            if (existing != directionTables.end()) return static_cast<std::uint8_t>(existing - directionTables.begin());
+            if (directionTables.size() > UINT8_MAX) return 0;
+            directionTables.push_back(directions);
+            return static_cast<std::uint8_t>(directionTables.size() - 1);
+        }
+
+        std::array<KeyBinding, kKeycodeCount> table{};
+        std::vector<BindingCandidate> candidates;
+        std::vector<DirectionTable> directionTables = std::vector<DirectionTable>(1);
+        std::bitset<kKeycodeCount> boundKeys;
+        static constexpr KeyBinding unbound{};
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Movement input quantized to the directions power attack animations exist for
+enum class MoveDirection : std::uint8_t
+{
+    kNeutral,
+    kForward,
+    kBack,
+    kLeft,
+    kRight
+};
+
+inline constexpr std::size_t kMoveDirectionCount = 5;
+
+// Direction a power attack is performed in for each movement direction, kNeutral leaves the animation graph alone
+using DirectionTable = std::array<MoveDirection, kMoveDirectionCount>;
+
+// Value of the graph's Direction variable, in turns clockwise from forward
+constexpr float GetGraphDirection(MoveDirection direction)
+{
+    switch (direction) {
+        case MoveDirection::kRight: return 0.25f;
+        case MoveDirection::kBack: return 0.5f;
+        case MoveDirection::kLeft: return 0.75f;
+        default: return 0.0f;
+    }
+}
+
+// Movement keys and stick as seen by the input events, so the direction never has to be queried from the game
+class MovementTracker
+{
+    public:
+        void SetKey(MoveDirection direction, bool pressed)
+        {
+            const auto bit = static_cast<std::uint8_t>(1 << std::to_underlying(direction));
+            heldKeys = pressed ? heldKeys | bit : heldKeys & ~bit;
+        }
+
+        void SetStick(float x, float y)
+        {
+            stickX = x;
+            stickY = y;
+        }
+
+        void Reset() { *this = {}; }
+
+        // The dominant axis wins, diagonals resolve to forward or back on a tie
+        MoveDirection Resolve() const
+        {
+            const float x = stickX + IsHeld(MoveDirection::kRight) - IsHeld(MoveDirection::kLeft);
+            const float y = stickY + IsHeld(MoveDirection::kForward) - IsHeld(MoveDirection::kBack);
+            if (std::abs(x) < kDeadzone && std::abs(y) < kDeadzone) return MoveDirection::kNeutral;
+            if (std::abs(y) >= std::abs(x)) return y > 0.0f ? MoveDirection::kForward : MoveDirection::kBack;
+            return x > 0.0f ? MoveDirection::kRight : MoveDirection::kLeft;
+        }
+
+    private:
+        float IsHeld(MoveDirection direction) const { return (heldKeys >> std::to_underlying(direction)) & 1 ? 1.0f : 0.0f; }
+
+        static constexpr float kDeadzone = 0.25f;
+
+        std::uint8_t heldKeys = 0;
+        float stickX = 0.0f;
+        float stickY = 0.0f;
+};
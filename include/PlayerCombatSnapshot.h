@@ -0,0 +1,23 @@
+#pragma once
+
+#include "WeaponProfile.h"
+
+// Player state needed to decide on attacks, refreshed only after an equip or animation graph event invalidated it
+struct PlayerCombatSnapshot
+{
+    bool isRightHandEquiped = false;
+    bool isRightHandUnarmed = false;
+    bool isLeftHandEquiped = false;
+    bool isLeftHandUnarmed = false;
+    bool hasTwoHandedWeapon = false;
+    WeaponProfile rightWeapon;
+    WeaponProfile leftWeapon;
+
+    bool isBlocking = false;
+    bool isAttacking = false;
+    bool inJumpState = false;
+    bool canAttack = false;
+
+    // Not covered by the events above, only read when stamina gating is enabled
+    float stamina = 0.0f;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+// Named zones for frame captures, compiled in with the PAK_ENABLE_PROFILING CMake option and removed otherwise
+#ifdef PAK_ENABLE_PROFILING
+#include <tracy/Tracy.hpp>
+#define PAK_ZONE(name) ZoneScopedN(name)
+#else
+#define PAK_ZONE(name)
+#endif
@@ -1,31 +1,44 @@
 #pragma once
 
-namespace Settings
+#include "AttackStateMachine.h"
+
+// [Weapon.Key] section, the key is a weapon type, a keyword EditorID or Plugin.esp|FormID
+struct WeaponOverride
+{
+    std::string key;
+    WeaponProfile profile;
+};
+
+// Settings parsed from the INI, never modified once published so the input handler can read it without locking
+struct SettingsSnapshot
 {
-    extern int rightHandKey;
-    extern int leftHandKey;
-    extern int bothHandsKey;
-    extern int comboKey;
-    
-    extern int rightHandKeyAlt1;
-    extern int leftHandKeyAlt1;
-    extern int bothHandsKeyAlt1;
-    extern int comboKeyAlt1;
+    std::vector<BindingProfile> profiles;
+    KeyBindingTable keyBindings;
+    AttackConfig attackConfig;
+    std::vector<WeaponOverride> weaponOverrides;  // Weapon profile N is weaponOverrides[N - 1]
 
-    extern int rightHandKeyAlt2;
-    extern int leftHandKeyAlt2;
-    extern int bothHandsKeyAlt2;
-    extern int comboKeyAlt2;
+    const WeaponProfile& GetWeaponProfile(std::uint8_t index) const
+    {
+        static constexpr WeaponProfile none{};
+        return index > 0 && index <= weaponOverrides.size() ? weaponOverrides[index - 1].profile : none;
+    }
+};
+
+namespace Settings
+{
+    extern bool recordInput;
+    extern bool enableStats;
 
-    extern bool holdConsecutivePA;
-    extern bool holdConsecutiveLA;
-    extern float consecutiveAttacksDelay;
-    extern bool consecutiveDualAttacks;
-    extern bool usingMCO;
-    
-    extern bool requireStaminaPA;
-    extern int staminaCost1H;
-    extern int staminaCost2H;
+    // Level changes apply on reload, the queue size only at startup
+    extern spdlog::level::level_enum logLevel;
+    extern spdlog::level::level_enum flushLevel;
+    extern std::size_t logQueueSize;
 
+    // Reads only the logging keys, so the logger can exist before the rest is loaded
+    void LoadLogSettings();
     void LoadSettings();
-}
\ No newline at end of file
+    // Reparses the INI if it was modified since the last load, returns true when a new snapshot was published
+    bool ReloadIfChanged();
+    // Current snapshot, a pointer stays valid for the whole session
+    const SettingsSnapshot* Get();
+}
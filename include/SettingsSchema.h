@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ranges>
+#include <string_view>
+#include <utility>
+
+#include "AttackStateMachine.h"
+#include "MoveDirection.h"
+
+// Typed description of every INI key, so parsing, range checks and defaults do not depend on the INI library or the logger
+namespace SettingsSchema
+{
+    enum class SettingType : std::uint8_t
+    {
+        kBool,
+        kInt,
+        kFloat,
+        kLogLevel,    // Level name, the number is its spdlog level
+        kChordKeys,   // Comma separated keycodes, e.g. "42,29"
+        kDirections   // Comma separated movement:attack pairs, e.g. "Neutral:Forward, Back:Back"
+    };
+
+    // A key that passed its type and range check
+    struct SettingValue
+    {
+        double number = 0.0;
+        std::string_view text;
+    };
+
+    template <class Values>
+    struct SettingSpec
+    {
+        const char* name;
+        SettingType type;
+        const char* defaultValue;  // Also what a missing [Settings] key is written as
+        double min;
+        double max;
+        void (*apply)(Values&, const SettingValue&);
+    };
+
+    inline constexpr double kMaxKeycode = kKeycodeCount - 1;
+
+    // Same order as spdlog::level::level_enum
+    inline constexpr std::array<std::string_view, 7> kLogLevelNames{ "trace", "debug", "info", "warning", "error", "critical", "off" };
+
+    // Everything the [Settings] section sets, copied to the snapshot and the globals once the whole section is parsed
+    struct SettingsValues
+    {
+        // The Primary, Alt1 and Alt2 keys are the first three profiles, each one with its combo key as chord
+        std::array<BindingProfile, 3> legacyProfiles;
+        AttackConfig attackConfig;
+        bool recordInput = false;
+        bool enableStats = false;
+        int logLevel = 2;
+        int flushLevel = 3;
+        std::size_t logQueueSize = 8192;
+    };
+
+    inline std::string_view Trim(std::string_view text)
+    {
+        const auto first = text.find_first_not_of(" \t");
+        if (first == std::string_view::npos) return {};
+        return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+    }
+
+    // The whole text has to be a number, trailing garbage is invalid too
+    template <class T>
+    std::optional<T> ParseNumber(std::string_view text)
+    {
+        T number{};
+        const auto last = text.data() + text.size();
+        const auto [end, error] = std::from_chars(text.data(), last, number);
+        if (error != std::errc{} || end != last) return std::nullopt;
+        return number;
+    }
+
+    // Also takes the short names spdlog accepts
+    inline std::optional<int> ParseLogLevel(std::string_view name)
+    {
+        if (name == "warn") return 3;
+        if (name == "err") return 4;
+        const auto level = std::ranges::find(kLogLevelNames, name);
+        if (level == kLogLevelNames.end()) return std::nullopt;
+        return static_cast<int>(level - kLogLevelNames.begin());
+    }
+
+    // Empty means no chord, a key out of range or more than kMaxChordKeys keys make the whole chord invalid
+    inline std::optional<std::array<int, kMaxChordKeys>> ParseChordKeys(std::string_view text)
+    {
+        std::array<int, kMaxChordKeys> keys;
+        keys.fill(-1);
+        std::size_t count = 0;
+        for (const auto part : std::views::split(text, ',')) {
+            const auto key = Trim(std::string_view(part.begin(), part.end()));
+            if (key.empty()) continue;
+            const auto keycode = ParseNumber<int>(key);
+            if (count == keys.size() || !keycode || *keycode < -1 || *keycode > static_cast<int>(kMaxKeycode)) return std::nullopt;
+            keys[count++] = *keycode;
+        }
+        return keys;
+    }
+
+    inline std::optional<MoveDirection> ParseDirection(std::string_view name)
+    {
+        constexpr std::array<std::pair<std::string_view, MoveDirection>, kMoveDirectionCount> names{ {
+            { "Neutral", MoveDirection::kNeutral },
+            { "Forward", MoveDirection::kForward },
+            { "Back", MoveDirection::kBack },
+            { "Left", MoveDirection::kLeft },
+            { "Right", MoveDirection::kRight }
+        } };
+        name = Trim(name);
+        for (const auto& [directionName, direction] : names) {
+            if (std::ranges::equal(name, directionName, [](char a, char b) { return std::tolower(a) == std::tolower(b); })) return direction;
+        }
+        return std::nullopt;
+    }
+
+    // Unlisted movements keep the direction, any malformed pair makes the whole table invalid
+    inline std::optional<DirectionTable> ParseDirections(std::string_view text)
+    {
+        DirectionTable directions{};
+        for (const auto part : std::views::split(text, ',')) {
+            const std::string_view pair(part.begin(), part.end());
+            if (Trim(pair).empty()) continue;
+            const auto separator = pair.find(':');
+            if (separator == std::string_view::npos) return std::nullopt;
+            const auto movement = ParseDirection(pair.substr(0, separator));
+            const auto attack = ParseDirection(pair.substr(separator + 1));
+            if (!movement || !attack) return std::nullopt;
+            directions[std::to_underlying(*movement)] = *attack;
+        }
+        return directions;
+    }
+
+    template <class Values>
+    std::optional<SettingValue> ParseSetting(const SettingSpec<Values>& spec, std::string_view text)
+    {
+        text = Trim(text);
+        SettingValue value{ 0.0, text };
+        switch (spec.type) {
+            case SettingType::kBool: {
+                if (text == "1" || text == "true") value.number = 1.0;
+                else if (text != "0" && text != "false") return std::nullopt;
+                break;
+            }
+            case SettingType::kInt: {
+                const auto number = ParseNumber<long>(text);
+                if (!number) return std::nullopt;
+                value.number = static_cast<double>(*number);
+                break;
+            }
+            case SettingType::kFloat: {
+                const auto number = ParseNumber<float>(text);
+                if (!number) return std::nullopt;
+                value.number = *number;
+                break;
+            }
+            case SettingType::kLogLevel: {
+                const auto level = ParseLogLevel(text);
+                if (!level) return std::nullopt;
+                value.number = *level;
+                break;
+            }
+            case SettingType::kChordKeys:
+                if (!ParseChordKeys(text)) return std::nullopt;
+                return value;
+            case SettingType::kDirections:
+                if (!ParseDirections(text)) return std::nullopt;
+                return value;
+        }
+        if (value.number < spec.min || value.number > spec.max) return std::nullopt;
+        return value;
+    }
+
+    // Applies every key of the schema in order. getValue(spec) returns the text of a key or null when it is missing,
+    // a missing key takes its default and an invalid one is passed to reportInvalid(spec, text) before taking its default
+    template <class Values, std::size_t Count, class GetValue, class ReportInvalid>
+    void LoadSchema(const std::array<SettingSpec<Values>, Count>& schema, Values& values, GetValue&& getValue, ReportInvalid&& reportInvalid)
+    {
+        for (const auto& spec : schema) {
+            const char* text = getValue(spec);
+            if (!text) text = spec.defaultValue;
+            auto value = ParseSetting(spec, text);
+            if (!value) {
+                reportInvalid(spec, std::string_view(text));
+                value = ParseSetting(spec, spec.defaultValue);
+            }
+            spec.apply(values, *value);
+        }
+    }
+
+    using SettingsSpec = SettingSpec<SettingsValues>;
+
+    // Every key of the [Settings] section in the order a generated INI lists them
+    inline constexpr std::array kSettingsSchema{
+        SettingsSpec{ "iRightHandKey", SettingType::kInt, "45", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[0].rightHandKey = static_cast<int>(v.number); } },
+        SettingsSpec{ "iLeftHandKey", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[0].leftHandKey = static_cast<int>(v.number); } },
+        SettingsSpec{ "iDualWieldKey", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[0].bothHandsKey = static_cast<int>(v.number); } },
+        SettingsSpec{ "iComboKey", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[0].chordKeys[0] = static_cast<int>(v.number); } },
+        SettingsSpec{ "iRightHandKeyAlt1", SettingType::kInt, "281", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[1].rightHandKey = static_cast<int>(v.number); } },
+        SettingsSpec{ "iLeftHandKeyAlt1", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[1].leftHandKey = static_cast<int>(v.number); } },
+        SettingsSpec{ "iDualWieldKeyAlt1", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[1].bothHandsKey = static_cast<int>(v.number); } },
+        SettingsSpec{ "iComboKeyAlt1", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[1].chordKeys[0] = static_cast<int>(v.number); } },
+        SettingsSpec{ "iRightHandKeyAlt2", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[2].rightHandKey = static_cast<int>(v.number); } },
+        SettingsSpec{ "iLeftHandKeyAlt2", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[2].leftHandKey = static_cast<int>(v.number); } },
+        SettingsSpec{ "iDualWieldKeyAlt2", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[2].bothHandsKey = static_cast<int>(v.number); } },
+        SettingsSpec{ "iComboKeyAlt2", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& s, const auto& v) { s.legacyProfiles[2].chordKeys[0] = static_cast<int>(v.number); } },
+        SettingsSpec{ "bConsecutivePowerAttacks", SettingType::kBool, "0", 0, 1, [](auto& s, const auto& v) { s.attackConfig.holdConsecutivePA = v.number != 0.0; } },
+        SettingsSpec{ "bConsecutiveLightAttacks", SettingType::kBool, "0", 0, 1, [](auto& s, const auto& v) { s.attackConfig.holdConsecutiveLA = v.number != 0.0; } },
+        SettingsSpec{ "fConsecutiveAttacksDelay", SettingType::kFloat, "0.5", 0, 10, [](auto& s, const auto& v) { s.attackConfig.consecutiveAttacksDelay = static_cast<float>(v.number); } },
+        SettingsSpec{ "bConsecutiveDualAttacks", SettingType::kBool, "0", 0, 1, [](auto& s, const auto& v) { s.attackConfig.consecutiveDualAttacks = v.number != 0.0; } },
+        SettingsSpec{ "bUsingMCO", SettingType::kBool, "0", 0, 1, [](auto& s, const auto& v) { s.attackConfig.usingMCO = v.number != 0.0; } },
+        SettingsSpec{ "bPowerAttacksRequireStamina", SettingType::kBool, "0", 0, 1, [](auto& s, const auto& v) { s.attackConfig.requireStaminaPA = v.number != 0.0; } },
+        SettingsSpec{ "iStaminaCost1H", SettingType::kInt, "15", 0, 1000, [](auto& s, const auto& v) { s.attackConfig.staminaCost1H = static_cast<int>(v.number); } },
+        SettingsSpec{ "iStaminaCost2H", SettingType::kInt, "30", 0, 1000, [](auto& s, const auto& v) { s.attackConfig.staminaCost2H = static_cast<int>(v.number); } },
+        SettingsSpec{ "fInputBufferWindow", SettingType::kFloat, "0.0", 0, 5, [](auto& s, const auto& v) { s.attackConfig.inputBufferWindow = static_cast<float>(v.number); } },
+        SettingsSpec{ "fSequenceWindow", SettingType::kFloat, "0.3", 0, 5, [](auto& s, const auto& v) { s.attackConfig.sequenceWindow = static_cast<float>(v.number); } },
+        SettingsSpec{ "bRecordInput", SettingType::kBool, "0", 0, 1, [](auto& s, const auto& v) { s.recordInput = v.number != 0.0; } },
+        SettingsSpec{ "bEnableStats", SettingType::kBool, "0", 0, 1, [](auto& s, const auto& v) { s.enableStats = v.number != 0.0; } },
+        SettingsSpec{ "sLogLevel", SettingType::kLogLevel, "info", 0, 6, [](auto& s, const auto& v) { s.logLevel = static_cast<int>(v.number); } },
+        SettingsSpec{ "sFlushLevel", SettingType::kLogLevel, "warn", 0, 6, [](auto& s, const auto& v) { s.flushLevel = static_cast<int>(v.number); } },
+        SettingsSpec{ "iLogQueueSize", SettingType::kInt, "8192", 256, 1 << 20, [](auto& s, const auto& v) { s.logQueueSize = static_cast<std::size_t>(v.number); } }
+    };
+
+    using ProfileSpec = SettingSpec<BindingProfile>;
+
+    // Keys of a [Profile.Name] section, the ones that are not set are unbound
+    inline constexpr std::array kProfileSchema{
+        ProfileSpec{ "iRightHandKey", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& p, const auto& v) { p.rightHandKey = static_cast<int>(v.number); } },
+        ProfileSpec{ "iLeftHandKey", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& p, const auto& v) { p.leftHandKey = static_cast<int>(v.number); } },
+        ProfileSpec{ "iDualWieldKey", SettingType::kInt, "-1", -1, kMaxKeycode, [](auto& p, const auto& v) { p.bothHandsKey = static_cast<int>(v.number); } },
+        ProfileSpec{ "sChordKeys", SettingType::kChordKeys, "", 0, 0, [](auto& p, const auto& v) { p.chordKeys = *ParseChordKeys(v.text); } },
+        ProfileSpec{ "iTaps", SettingType::kInt, "0", 0, 8, [](auto& p, const auto& v) { p.taps = static_cast<std::uint32_t>(v.number); } },
+        ProfileSpec{ "fHoldTime", SettingType::kFloat, "0.0", 0, 10, [](auto& p, const auto& v) { p.holdTime = static_cast<float>(v.number); } },
+        ProfileSpec{ "sDirections", SettingType::kDirections, "", 0, 0, [](auto& p, const auto& v) { p.directions = *ParseDirections(v.text); } }
+    };
+
+    using WeaponSpec = SettingSpec<WeaponProfile>;
+
+    // Keys of a [Weapon.Key] section, the ones that are not set keep the global settings
+    inline constexpr std::array kWeaponSchema{
+        WeaponSpec{ "iStaminaCost", SettingType::kInt, "-1", -1, 1000, [](auto& w, const auto& v) { w.staminaCost = static_cast<int>(v.number); } },
+        WeaponSpec{ "fConsecutiveAttacksDelay", SettingType::kFloat, "-1.0", -1, 10, [](auto& w, const auto& v) { w.repeatDelay = static_cast<float>(v.number); } },
+        WeaponSpec{ "iLightAttackFirst", SettingType::kInt, "-1", -1, 1, [](auto& w, const auto& v) { w.lightAttackFirst = static_cast<std::int8_t>(v.number); } }
+    };
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Immutable value read without locking from any thread, replaced as a whole by the writers.
+// Replaced values are never freed since a reader may still hold them: only use it for data republished
+// on rare occasions (reloads, remaps), where the retired copies cost next to nothing
+template <class T>
+class SnapshotPublisher
+{
+    public:
+        // Null until the first publish, a returned pointer stays valid as long as the publisher
+        const T* Get() const { return current.load(std::memory_order_acquire); }
+
+        const T* Publish(std::unique_ptr<const T> value)
+        {
+            const std::scoped_lock lock(writeLock);
+            return PublishLocked(std::move(value));
+        }
+
+        // Keeps the current value when it compares equal, returns false then
+        bool PublishIfChanged(std::unique_ptr<const T> value)
+        {
+            const std::scoped_lock lock(writeLock);
+            if (const auto published = current.load(std::memory_order_relaxed); published && *published == *value) return false;
+            PublishLocked(std::move(value));
+            return true;
+        }
+
+        // Values published so far, including the current one
+        std::size_t GetPublishCount() const
+        {
+            const std::scoped_lock lock(writeLock);
+            return retired.size();
+        }
+
+    private:
+        const T* PublishLocked(std::unique_ptr<const T> value)
+        {
+            const auto published = retired.emplace_back(std::move(value)).get();
+            current.store(published, std::memory_order_release);
+            return published;
+        }
+
+        std::atomic<const T*> current = nullptr;
+        std::vector<std::unique_ptr<const T>> retired;
+        mutable std::mutex writeLock;
+};
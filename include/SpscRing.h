@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free ring for one producer thread and one consumer thread
+template <class T, std::size_t Capacity>
+class SpscRing
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+
+    public:
+        // Never blocks, returns false when the ring is full
+        bool TryPush(const T& item)
+        {
+            const auto head = writeIndex.load(std::memory_order_relaxed);
+            if (head - readIndex.load(std::memory_order_acquire) == Capacity) return false;
+            buffer[head & (Capacity - 1)] = item;
+            writeIndex.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool TryPop(T& item)
+        {
+            const auto tail = readIndex.load(std::memory_order_relaxed);
+            if (tail == writeIndex.load(std::memory_order_acquire)) return false;
+            item = buffer[tail & (Capacity - 1)];
+            readIndex.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        std::size_t Size() const
+        {
+            return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+        }
+
+    private:
+        alignas(64) std::atomic<std::size_t> writeIndex = 0;
+        alignas(64) std::atomic<std::size_t> readIndex = 0;
+        std::array<T, Capacity> buffer{};
+};
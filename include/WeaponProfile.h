@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Overrides for a weapon from the INI, the unset fields keep the global settings
+struct WeaponProfile
+{
+    int staminaCost = -1;               // Power attack stamina cost, -1 uses iStaminaCost1H or iStaminaCost2H
+    float repeatDelay = -1.0f;          // Hold repeat delay, negative uses fConsecutiveAttacksDelay
+    std::int8_t lightAttackFirst = -1;  // Light attack before the power attack, -1 uses the default rules, 0 never, 1 always
+};
+
+// Index of a weapon profile, 0 means no override
+inline constexpr std::size_t kMaxWeaponProfiles = 255;
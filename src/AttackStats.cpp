@@ -0,0 +1,104 @@
+#include "AttackStats.h"
+
+namespace
+{
+    constexpr std::array<std::string_view, static_cast<std::size_t>(AttackOutcome::kCount)> outcomeNames{
+        "none", "combo PA", "PA", "repeat PA", "repeat LA", "buffered PA", "stamina rejected", "state rejected", "menu rejected"
+    };
+
+    constexpr std::array<std::string_view, static_cast<std::size_t>(AttackStats::Timing::kCount)> timingNames{ "batch", "event", "update", "drain" };
+
+    std::uint64_t Read(std::atomic<std::uint64_t>& counter, bool reset)
+    {
+        return reset ? counter.exchange(0, std::memory_order_relaxed) : counter.load(std::memory_order_relaxed);
+    }
+}
+
+AttackStats* AttackStats::GetSingleton()
+{
+    static AttackStats instance;
+    return &instance;
+}
+
+void AttackStats::RecordTiming(Timing timing, std::uint64_t ns) {
+    timings[static_cast<std::size_t>(timing)].Add(ns);
+}
+
+void AttackStats::RecordOutcome(AttackOutcome outcome) {
+    if (outcome == AttackOutcome::kNone || outcome >= AttackOutcome::kCount) return;
+    outcomes[static_cast<std::size_t>(outcome)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void AttackStats::RecordDispatchFailed() {
+    dispatchFailed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AttackStats::RecordQueueDepth(std::size_t depth) {
+    queueDepth.Add(depth);
+}
+
+void AttackStats::RecordCollapsedActions(std::size_t count) {
+    collapsedActions.fetch_add(count, std::memory_order_relaxed);
+}
+
+void AttackStats::RecordLatency(std::uint64_t ns) {
+    const auto bucket = std::ranges::lower_bound(latencyBucketsUs, ns / 1000) - latencyBucketsUs.begin();
+    latencyBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<std::string> AttackStats::Summarize(bool reset) {
+    std::vector<std::string> lines;
+
+    for (std::size_t i = 0; i < timings.size(); ++i) {
+        const auto count = Read(timings[i].count, reset);
+        const auto totalNs = Read(timings[i].total, reset);
+        const auto maxNs = Read(timings[i].max, reset);
+        const auto averageNs = count ? totalNs / count : 0;
+        lines.push_back(std::format("{}: {} calls, avg {:.2f} us, max {:.2f} us", timingNames[i], count, averageNs / 1000.0, maxNs / 1000.0));
+    }
+
+    std::string outcomeLine = "outcomes:";
+    for (std::size_t i = 1; i < outcomes.size(); ++i) {
+        outcomeLine += std::format(" {} {},", outcomeNames[i], Read(outcomes[i], reset));
+    }
+    outcomeLine += std::format(" dispatch failed {}", Read(dispatchFailed, reset));
+    lines.push_back(std::move(outcomeLine));
+
+    const auto drains = Read(queueDepth.count, reset);
+    const auto queued = Read(queueDepth.total, reset);
+    const auto maxDepth = Read(queueDepth.max, reset);
+    lines.push_back(std::format("action queue: {} drains, avg depth {:.2f}, max depth {}, {} actions collapsed", drains,
+                                drains ? static_cast<double>(queued) / drains : 0.0, maxDepth, Read(collapsedActions, reset)));
+
+    std::array<std::uint64_t, latencyBucketsUs.size() + 1> buckets{};
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        buckets[i] = Read(latencyBuckets[i], reset);
+        total += buckets[i];
+    }
+
+    // Percentiles are reported as the upper bound of the bucket they fall in
+    auto percentile = [&](std::uint64_t permille) -> std::string {
+        const auto target = (total * permille + 999) / 1000;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < latencyBucketsUs.size(); ++i) {
+            seen += buckets[i];
+            if (seen >= target) return std::format("<={} us", latencyBucketsUs[i]);
+        }
+        return std::format(">{} us", latencyBucketsUs.back());
+    };
+
+    std::string latencyLine = std::format("key down to dispatch: {} samples", total);
+    if (total) latencyLine += std::format(", p50 {}, p90 {}, p99 {}", percentile(500), percentile(900), percentile(990));
+    lines.push_back(std::move(latencyLine));
+
+    std::string bucketLine = "latency buckets (us):";
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        if (!buckets[i]) continue;
+        if (i < latencyBucketsUs.size()) bucketLine += std::format(" <={}:{}", latencyBucketsUs[i], buckets[i]);
+        else bucketLine += std::format(" >{}:{}", latencyBucketsUs.back(), buckets[i]);
+    }
+    lines.push_back(std::move(bucketLine));
+
+    return lines;
+}
@@ -0,0 +1,36 @@
+#include "ConsoleCommands.h"
+#include "AttackStats.h"
+
+bool ConsoleCommands::PrintStats::Execute(const RE::SCRIPT_PARAMETER*, RE::SCRIPT_FUNCTION::ScriptData*, RE::TESObjectREFR*, RE::TESObjectREFR*,
+                                          RE::Script*, RE::ScriptLocals*, double&, std::uint32_t&) {
+    const auto console = RE::ConsoleLog::GetSingleton();
+    if (!console) return true;
+
+    const auto stats = AttackStats::GetSingleton();
+    if (!stats->IsEnabled()) {
+        console->Print("Power attack stats are disabled, set bEnableStats = 1 in PowerAttackKey.ini");
+        return true;
+    }
+    for (const auto& line : stats->Summarize(true)) {
+        console->Print("%s", line.c_str());
+    }
+    return true;
+}
+
+void ConsoleCommands::Register() {
+    // Takes over an unused debug command, the same way most plugins add console commands
+    const auto command = RE::SCRIPT_FUNCTION::LocateConsoleCommand("ToggleHeapTracking");
+    if (!command) {
+        logger::warn("Could not register the PowerAttackStats console command");
+        return;
+    }
+
+    command->functionName = "PowerAttackStats";
+    command->shortName = "pakstats";
+    command->helpString = "Prints and resets the power attack input statistics";
+    command->referenceFunction = false;
+    command->SetParameters();
+    command->executeFunction = &PrintStats::Execute;
+    command->conditionFunction = nullptr;
+    logger::info("Registered PowerAttackStats console command");
+}
@@ -0,0 +1,183 @@
+#include "EventHandlers.h"
+#include "InputHandler.h"
+#include "Settings.h"
+
+namespace
+{
+    static_assert(std::to_underlying(WeaponType::kHandToHandMelee) == std::to_underlying(RE::WEAPON_TYPE::kHandToHandMelee));
+    static_assert(std::to_underlying(WeaponType::kTwoHandAxe) == std::to_underlying(RE::WEAPON_TYPE::kTwoHandAxe));
+    static_assert(std::to_underlying(WeaponType::kCrossbow) == std::to_underlying(RE::WEAPON_TYPE::kCrossbow));
+
+    // Names of the [Weapon.Type] sections, indexed by WeaponType
+    constexpr std::array<std::string_view, kWeaponTypeCount> kWeaponTypeNames{
+        "HandToHand", "Sword", "Dagger", "WarAxe", "Mace", "Greatsword", "Battleaxe", "Bow", "Staff", "Crossbow"
+    };
+
+    struct PlayerEquipment
+    {
+        const RE::PlayerCharacter* player;
+        const WeaponProfileLookup* profiles;
+
+        EquippedObject GetEquippedObject(bool leftHand) const {
+            EquippedObject object;
+            const auto* form = player->GetEquippedObject(leftHand);
+            object.empty = form == nullptr;
+            object.profile = profiles ? profiles->GetProfile(form) : 0;
+            if (const auto* weapon = form ? form->As<RE::TESObjectWEAP>() : nullptr) {
+                object.isWeapon = true;
+                object.weaponType = static_cast<WeaponType>(weapon->GetWeaponType());
+            }
+            return object;
+        }
+    };
+
+    // Plugin.esp|0x123456, the FormID is local to the plugin
+    RE::FormID LookupPluginFormID(std::string_view key)
+    {
+        const auto separator = key.find('|');
+        if (separator == std::string_view::npos) return 0;
+
+        const std::string plugin(key.substr(0, separator));
+        const auto localID = std::strtoul(std::string(key.substr(separator + 1)).c_str(), nullptr, 16);
+        const auto dataHandler = RE::TESDataHandler::GetSingleton();
+        return dataHandler ? dataHandler->LookupFormID(static_cast<RE::FormID>(localID), plugin) : 0;
+    }
+
+    // Attack window annotations, weaponSwing starts the next swing of a combo
+    constexpr std::array<std::pair<std::string_view, AttackWindowEvent>, 7> kAttackWindowTags{ {
+        { "weaponSwing", AttackWindowEvent::kSwing },
+        { "weaponLeftSwing", AttackWindowEvent::kSwing },
+        { "MCO_WinOpen", AttackWindowEvent::kLightWindowOpen },
+        { "MCO_WinClose", AttackWindowEvent::kLightWindowClose },
+        { "MCO_PowerWinOpen", AttackWindowEvent::kPowerWindowOpen },
+        { "MCO_PowerWinClose", AttackWindowEvent::kPowerWindowClose },
+        { "attackStop", AttackWindowEvent::kAttackStop }
+    } };
+
+    // Graph events after which a buffered power attack may go through
+    constexpr std::array kAttackAllowedTags{
+        "attackStop", "attackWinStart", "MCO_WinOpen", "MCO_PowerWinOpen",
+        "weaponDraw", "GetUpEnd", "JumpLandEnd", "blockStop", "bashStop"
+    };
+}
+
+EquipEventHandler* EquipEventHandler::GetSingleton()
+{
+    static EquipEventHandler instance;
+    return &instance;
+}
+
+RE::BSEventNotifyControl EquipEventHandler::ProcessEvent(
+    const RE::TESEquipEvent* a_event,
+    RE::BSTEventSource<RE::TESEquipEvent>*)
+{
+    if (a_event && a_event->actor && a_event->actor->IsPlayerRef()) {
+        // The equipped objects are only updated once the event has been dispatched
+        QueueRefresh();
+    }
+    return RE::BSEventNotifyControl::kContinue;
+}
+
+void EquipEventHandler::QueueRefresh() {
+    SKSE::GetTaskInterface()->AddTask([]() { EquipEventHandler::GetSingleton()->Refresh(); });
+}
+
+void EquipEventHandler::Refresh() {
+    const auto player = RE::PlayerCharacter::GetSingleton();
+    if (!player) return;
+
+    const auto profiles = weaponProfiles.Get();
+    auto next = ClassifyEquipment(PlayerEquipment{ player, profiles });
+    next.profileVersion = profiles ? profiles->version : 0;
+
+    // Only the main thread writes, see QueueRefresh
+    state.store(next, std::memory_order_release);
+    InputEventHandler::GetSingleton()->InvalidateSnapshot();
+}
+
+void EquipEventHandler::ResolveWeaponProfiles() {
+    auto lookup = std::make_unique<WeaponProfileLookup>();
+    lookup->settings = Settings::Get();
+    lookup->version = lookupVersion.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto& profileByWeapon = lookup->profileByWeapon;
+    auto& profileByType = lookup->profileByType;
+
+    const auto& overrides = lookup->settings->weaponOverrides;
+    std::vector<std::pair<const RE::BGSKeyword*, std::uint8_t>> keywordProfiles;
+    std::vector<std::pair<RE::FormID, std::uint8_t>> formProfiles;
+
+    // The first section that applies wins within a kind, FormIDs take priority over keywords and keywords over types
+    for (std::size_t i = 0; i < overrides.size(); ++i) {
+        const auto& key = overrides[i].key;
+        const auto profile = static_cast<std::uint8_t>(i + 1);
+
+        if (key.contains('|')) {
+            if (const auto formID = LookupPluginFormID(key)) formProfiles.emplace_back(formID, profile);
+            else logger::warn("Weapon override {}: form not found", key);
+        } else if (const auto type = std::ranges::find(kWeaponTypeNames, key); type != kWeaponTypeNames.end()) {
+            auto& typeProfile = profileByType[type - kWeaponTypeNames.begin()];
+            if (!typeProfile) typeProfile = profile;
+        } else if (const auto keyword = RE::TESForm::LookupByEditorID<RE::BGSKeyword>(key)) {
+            keywordProfiles.emplace_back(keyword, profile);
+        } else {
+            logger::warn("Weapon override {}: not a weapon type, keyword or Plugin.esp|FormID", key);
+        }
+    }
+
+    if (!keywordProfiles.empty()) {
+        if (const auto dataHandler = RE::TESDataHandler::GetSingleton()) {
+            for (const auto weapon : dataHandler->GetFormArray<RE::TESObjectWEAP>()) {
+                const auto match = std::ranges::find_if(keywordProfiles, [&](const auto& entry) { return weapon && weapon->HasKeyword(entry.first); });
+                if (match != keywordProfiles.end()) profileByWeapon.emplace(weapon->GetFormID(), match->second);
+            }
+        }
+    }
+    // Assigned last so they replace the keyword matches, in reverse so the first section for a form wins
+    for (const auto& [formID, profile] : formProfiles | std::views::reverse) {
+        profileByWeapon[formID] = profile;
+    }
+
+    logger::info("Resolved {} weapon overrides for {} weapons", overrides.size(), profileByWeapon.size());
+    weaponProfiles.Publish(std::move(lookup));
+    QueueRefresh();
+}
+
+std::uint8_t WeaponProfileLookup::GetProfile(const RE::TESForm* form) const {
+    if (!form) return profileByType[std::to_underlying(WeaponType::kHandToHandMelee)];
+
+    const auto weapon = form->As<RE::TESObjectWEAP>();
+    if (!weapon) return 0;
+    if (const auto it = profileByWeapon.find(weapon->GetFormID()); it != profileByWeapon.end()) return it->second;
+    return profileByType[std::to_underlying(weapon->GetWeaponType())];
+}
+
+AnimationEventHandler* AnimationEventHandler::GetSingleton()
+{
+    static AnimationEventHandler instance;
+    return &instance;
+}
+
+RE::BSEventNotifyControl AnimationEventHandler::ProcessEvent(
+    const RE::BSAnimationGraphEvent* a_event,
+    RE::BSTEventSource<RE::BSAnimationGraphEvent>*)
+{
+    if (a_event) {
+        const auto handler = InputEventHandler::GetSingleton();
+        handler->InvalidateSnapshot();
+        if (std::ranges::any_of(kAttackAllowedTags, [&](const char* tag) { return a_event->tag == tag; })) {
+            handler->SignalAttackAllowed();
+        }
+        const auto window = std::ranges::find(kAttackWindowTags, std::string_view(a_event->tag), &std::pair<std::string_view, AttackWindowEvent>::first);
+        if (window != kAttackWindowTags.end()) handler->SignalAttackWindow(window->second);
+    }
+    return RE::BSEventNotifyControl::kContinue;
+}
+
+void AnimationEventHandler::Register() {
+    // The player's graph is rebuilt on every load, so the sink has to be attached again
+    if (const auto player = RE::PlayerCharacter::GetSingleton()) {
+        player->RemoveAnimationGraphEventSink(this);
+        player->AddAnimationGraphEventSink(this);
+    }
+    InputEventHandler::GetSingleton()->InvalidateSnapshot();
+}
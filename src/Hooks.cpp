@@ -0,0 +1,13 @@
+#include "Hooks.h"
+#include "InputHandler.h"
+
+void Hooks::PlayerUpdate::Update(RE::PlayerCharacter* a_this, float a_delta) {
+    _Update(a_this, a_delta);
+    InputEventHandler::GetSingleton()->Update(a_this);
+}
+
+void Hooks::Install() {
+    REL::Relocation<std::uintptr_t> playerVtbl{ RE::VTABLE_PlayerCharacter[0] };
+    PlayerUpdate::_Update = playerVtbl.write_vfunc(0xAD, PlayerUpdate::Update);
+    logger::info("Installed player update hook");
+}
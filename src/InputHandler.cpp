@@ -1,5 +1,10 @@
 #include "InputHandler.h"
 #include "Settings.h"
+#include "EventHandlers.h"
+#include "InputBatch.h"
+#include "InputRecorder.h"
+#include "AttackStats.h"
+#include "Profiling.h"
 
 InputEventHandler* InputEventHandler::GetSingleton()
 {
@@ -11,337 +16,412 @@ RE::BSEventNotifyControl InputEventHandler::ProcessEvent(
     RE::InputEvent* const* a_event,
     RE::BSTEventSource<RE::InputEvent*>*)
 {
+    PAK_ZONE("ProcessEvent");
     if (!a_event) {
         return RE::BSEventNotifyControl::kContinue;
     }
 
-    if (const auto ui{ RE::UI::GetSingleton() }) {
-
-        if (const auto control_map{ RE::ControlMap::GetSingleton() }; control_map->IsMovementControlsEnabled()) {
-            const auto player = RE::PlayerCharacter::GetSingleton();
-            if (player && player->Is3DLoaded()) {
-
-                for (auto e{ *a_event }; e != nullptr; e = e->next) {
-                    if (const auto btn_event{ e->AsButtonEvent() }) {
- 
-                        const auto device{ btn_event->GetDevice() };
-                        auto keycode{ btn_event->GetIDCode() };
-
-                        using enum RE::INPUT_DEVICE;
-                        if (device != kKeyboard && device != kGamepad && device != kMouse) return RE::BSEventNotifyControl::kContinue;
-                        if (device == kGamepad) keycode = SKSE::InputMap::GamepadMaskToKeycode(keycode);
-                        if (device == kMouse) keycode = keycode + 256;
-
-                        // Update state of combo keys
-                        if (Settings::comboKey>0 && keycode == Settings::comboKey) comboActive = btn_event->IsPressed();
-                        if (Settings::comboKeyAlt1>0 && keycode == Settings::comboKeyAlt1) comboActiveAlt1 = btn_event->IsPressed();
-                        if (Settings::comboKeyAlt2>0 && keycode == Settings::comboKeyAlt2) comboActiveAlt2 = btn_event->IsPressed();
-
-                        // Check if any menu is open
-                        if (ui->GameIsPaused() || ui->IsApplicationMenuOpen() || ui->IsItemMenuOpen() || ui->IsModalMenuOpen() ||
-                            ui->IsMenuOpen("Dialogue Menu") || ui->IsMenuOpen("Console") || ui->IsMenuOpen("TweenMenu") || ui->IsMenuOpen("LevelUp Menu")) {
-                            return RE::BSEventNotifyControl::kContinue;
-                        }
-
-                        if (IsRightHandKey(device, keycode)) rightHandKeyPressed = btn_event->IsPressed();
-                        if (IsLeftHandKey(device, keycode)) leftHandKeyPressed = btn_event->IsPressed();
-
-                        bool isRightHandEquiped = HasEquipedWeapon(player, false);
-                        bool isRightHandUnarmed = IsHandUnarmed(player, false);
-                        bool isLeftHandEquiped = HasEquipedWeapon(player, true);
-                        bool isLeftHandUnarmed = IsHandUnarmed(player, true);
-
-                        bool isPowerAttackKey = keycode == Settings::rightHandKey || keycode == Settings::leftHandKey || keycode == Settings::bothHandsKey
-                                               || keycode == Settings::rightHandKeyAlt1 || keycode == Settings::leftHandKeyAlt1 || keycode == Settings::bothHandsKeyAlt1
-                                               || keycode == Settings::rightHandKeyAlt2 || keycode == Settings::leftHandKeyAlt2 || keycode == Settings::bothHandsKeyAlt2;
-
-                        // Reset variables when keys are is first pressed or up
-                        if ((btn_event->IsDown() || btn_event->IsUp()) && isPowerAttackKey){
-                            powerAttackWaiting = false;
-                            powerAttackHeldTime = 0.0f;
-                        }
-                        if ((btn_event->IsDown() || btn_event->IsUp()) && IsRightHandKey(device, keycode)){
-                            rightAttackWaiting = false;
-                            rightAttackHeldTime = 0.0f;
-                        }
-                        if ((btn_event->IsDown() || btn_event->IsUp()) && IsLeftHandKey(device, keycode)){
-                            leftAttackWaiting = false;
-                            leftAttackHeldTime = 0.0f;
-                        }
-                                
-                        bool bIsBlocking = false;
-                        player->GetGraphVariableBool("Isblocking", bIsBlocking);
-                        bool bIsAttacking = false;
-                        player->GetGraphVariableBool("IsAttacking", bIsAttacking);
-
-                        // Check if player cannot do attacks
-                        const auto playerState = player->AsActorState();
-                        if (!(!player->IsInKillMove() &&  playerState->GetWeaponState() == RE::WEAPON_STATE::kDrawn &&
-                            playerState->GetSitSleepState() == RE::SIT_SLEEP_STATE::kNormal && playerState->GetKnockState() == RE::KNOCK_STATE_ENUM::kNormal &&
-                            playerState->GetKnockState() == RE::KNOCK_STATE_ENUM::kNormal && playerState->GetFlyState() == RE::FLY_STATE::kNone)){
-                            // logger::info("Player cannot attack currently, ignoring input");
-                            return RE::BSEventNotifyControl::kContinue;
-                        }
-
-                        // Check if any power attack key is being pressed
-                        if (isPowerAttackKey && (btn_event->IsDown() || (btn_event->IsHeld() && Settings::holdConsecutivePA && bIsAttacking))) {
-                            // If the power attack key is held, apply a wait time between actions
-                            if (btn_event->IsHeld() && Settings::holdConsecutivePA && bIsAttacking) {
-                                float currentPowerAttackHeldTime = btn_event->heldDownSecs;
-                                if (!powerAttackWaiting) powerAttackHeldTime = currentPowerAttackHeldTime;
-                                // logger::info("Difference: {}",currentPowerAttackHeldTime - powerAttackHeldTime);
-                                // Check if wait time expired
-                                if (currentPowerAttackHeldTime - powerAttackHeldTime <= Settings::consecutiveAttacksDelay) {
-                                    powerAttackWaiting = true;
-                                    return RE::BSEventNotifyControl::kContinue;
-                                } else {
-                                    powerAttackWaiting = false;
-                                }
-                            }
-
-                            bool isUsingCombo = comboActive && !(comboActiveAlt1 || comboActiveAlt2);
-                            bool isUsingComboAlt1 = comboActiveAlt1 && !(comboActive || comboActiveAlt2);
-                            bool isUsingComboAlt2 = comboActiveAlt2 && !(comboActive || comboActiveAlt1);
-                            bool isKeyWithCombo = false;
-
-                            if (!(btn_event->IsHeld() && bIsBlocking)){
-
-                                // Depending of the pressed keys, check for equiped weapon to trigger action
-                                // Combos take priority
-                                if (isUsingCombo && Settings::comboKey>0){
-                                    if (keycode == Settings::rightHandKey && isRightHandEquiped){
-                                        if (PerformRightHandPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                    } else if (keycode == Settings::leftHandKey && isLeftHandEquiped && (!isLeftHandUnarmed || (isLeftHandUnarmed && isRightHandUnarmed))){
-                                        if (PerformLeftHandPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                    } else if (keycode == Settings::bothHandsKey){
-                                        if (PerformBothHandsPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                    }
-                                    if (keycode == Settings::rightHandKey || keycode == Settings::leftHandKey || keycode == Settings::bothHandsKey) isKeyWithCombo = true;
-                                }
-                                if (isUsingComboAlt1 && Settings::comboKeyAlt1>0){
-                                    if (keycode == Settings::rightHandKeyAlt1 && isRightHandEquiped){
-                                        if (PerformRightHandPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                    } else if (keycode == Settings::leftHandKeyAlt1 && isLeftHandEquiped && (!isLeftHandUnarmed || (isLeftHandUnarmed && isRightHandUnarmed))){
-                                        if (PerformLeftHandPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                    } else if (keycode == Settings::bothHandsKeyAlt1){
-                                        if (PerformBothHandsPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                    }
-                                    if (keycode == Settings::rightHandKeyAlt1 || keycode == Settings::leftHandKeyAlt1 || keycode == Settings::bothHandsKeyAlt1) isKeyWithCombo = true;
-                                }
-                                if (isUsingComboAlt2 && Settings::comboKeyAlt2>0){
-                                    if (keycode == Settings::rightHandKeyAlt2 && isRightHandEquiped){
-                                        if (PerformRightHandPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                    } else if (keycode == Settings::leftHandKeyAlt2 && isLeftHandEquiped && (!isLeftHandUnarmed || (isLeftHandUnarmed && isRightHandUnarmed))){
-                                        if (PerformLeftHandPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                    } else if (keycode == Settings::bothHandsKeyAlt2){
-                                        if (PerformBothHandsPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                    }
-                                    if (keycode == Settings::rightHandKeyAlt2 || keycode == Settings::leftHandKeyAlt2 || keycode == Settings::bothHandsKeyAlt2) isKeyWithCombo = true;
-                                }
-
-                                // If key is not part of a combo or if the related combo is disabled.
-                                if (((keycode == Settings::rightHandKey && Settings::comboKey<=0) || 
-                                     (keycode == Settings::rightHandKeyAlt1 && Settings::comboKeyAlt1<=0) || 
-                                     (keycode == Settings::rightHandKeyAlt2 && Settings::comboKeyAlt2<=0) ) && isRightHandEquiped && !isKeyWithCombo){
-                                    if (PerformRightHandPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                }else if (( (keycode == Settings::leftHandKey && Settings::comboKey<=0) || 
-                                            (keycode == Settings::leftHandKeyAlt1 && Settings::comboKeyAlt1<=0) || 
-                                            (keycode == Settings::leftHandKeyAlt2 && Settings::comboKeyAlt2<=0)) &&
-                                            isLeftHandEquiped && (!isLeftHandUnarmed || (isLeftHandUnarmed && isRightHandUnarmed)) && !isKeyWithCombo){
-                                    if (PerformLeftHandPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                }else if (( (keycode == Settings::bothHandsKey && Settings::comboKey<=0)) || 
-                                            (keycode == Settings::bothHandsKeyAlt1 && Settings::comboKeyAlt1<=0) || 
-                                            (keycode == Settings::bothHandsKeyAlt2 && Settings::comboKeyAlt2<=0) && !isKeyWithCombo){
-                                    if (PerformBothHandsPA(player)) return RE::BSEventNotifyControl::kContinue; 
-                                }
-
-                            }
-                        }
-
-                        // Logic related to holding attack key with consecutive light attacks enabled
-                        if (rightHandKeyPressed && leftHandKeyPressed && Settings::holdConsecutiveLA && Settings::consecutiveDualAttacks && bIsAttacking) {
-                            if (btn_event->IsHeld() && isLeftHandEquiped && isRightHandEquiped && !bIsBlocking) {
-                                // If the attack key is held, apply a wait time between actions
-                                float currentRightAttackHeldTime = btn_event->heldDownSecs;
-                                float currentLeftAttackHeldTime = btn_event->heldDownSecs;
-                                if (!rightAttackWaiting) rightAttackHeldTime = currentRightAttackHeldTime;
-                                if (!leftAttackWaiting) leftAttackHeldTime = currentLeftAttackHeldTime;
-                                // logger::info("Difference: {}",currentPowerAttackHeldTime - powerAttackHeldTime);
-                                // Check if wait time expired
-                                if (currentRightAttackHeldTime - rightAttackHeldTime <= Settings::consecutiveAttacksDelay ||
-                                    currentLeftAttackHeldTime - leftAttackHeldTime <= Settings::consecutiveAttacksDelay) {
-                                    rightAttackWaiting = true;
-                                    leftAttackWaiting = true;
-                                    PerformAction(LABothHandsAction, player);
-                                } else {
-                                    rightAttackWaiting = false;
-                                    leftAttackWaiting = false;
-                                }
-                            }
-                            return RE::BSEventNotifyControl::kContinue;
-                        } else if (IsRightHandKey(device, keycode) && Settings::holdConsecutiveLA && bIsAttacking) {
-                            if (btn_event->IsHeld() && isRightHandEquiped && !bIsBlocking) {
-                                // If the attack key is held, apply a wait time between actions
-                                float currentRightAttackHeldTime = btn_event->heldDownSecs;
-                                if (!rightAttackWaiting) rightAttackHeldTime = currentRightAttackHeldTime;
-                                // logger::info("Difference: {}",currentPowerAttackHeldTime - powerAttackHeldTime);
-                                // Check if wait time expired
-                                if (currentRightAttackHeldTime - rightAttackHeldTime <= Settings::consecutiveAttacksDelay) {
-                                    rightAttackWaiting = true;
-                                    PerformAction(LARightHandAction, player);
-                                } else {
-                                    rightAttackWaiting = false;
-                                }
-                            }
-                            return RE::BSEventNotifyControl::kContinue;
-                        } else if (IsLeftHandKey(device, keycode) && Settings::holdConsecutiveLA && bIsAttacking){
-                            if (btn_event->IsHeld() && isLeftHandEquiped && !bIsBlocking) {
-                                // If the attack key is held, apply a wait time between actions
-                                float currentLeftAttackHeldTime = btn_event->heldDownSecs;
-                                if (!leftAttackWaiting) leftAttackHeldTime = currentLeftAttackHeldTime;
-                                // logger::info("Difference: {}",currentPowerAttackHeldTime - powerAttackHeldTime);
-                                // Check if wait time expired
-                                if (currentLeftAttackHeldTime - leftAttackHeldTime <= Settings::consecutiveAttacksDelay) {
-                                    leftAttackWaiting = true;
-                                    PerformAction(LALeftHandAction, player);
-                                } else {
-                                    leftAttackWaiting = false;
-                                }
-                            }
-                            return RE::BSEventNotifyControl::kContinue;
-                        }
-                    }
-                }
-            }
+    const auto stats = AttackStats::GetSingleton();
+    const bool statsEnabled = stats->IsEnabled();
+    const ScopedTiming batchTiming(AttackStats::Timing::kBatch);
+    // Key down time as seen by the plugin, the event itself has no timestamp
+    const auto received = statsEnabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+    // First pass over the whole chain, then the decisions once per edge
+    CollectInputs(*a_event);
+    if (batchInputs.empty()) {
+        return RE::BSEventNotifyControl::kContinue;
+    }
+
+    // Loaded once so a reload never changes the settings in the middle of a batch
+    const auto settings = Settings::Get();
+    const auto recorder = InputRecorder::GetSingleton();
+    const auto player = RE::PlayerCharacter::GetSingleton();
+    const auto controlMap = RE::ControlMap::GetSingleton();
+
+    // Without a decision the key state is still tracked, so a release in the same batch is never lost
+    const bool menuBlocked = menuBlocking.load(std::memory_order_acquire);
+    const bool canDecide = !menuBlocked && controlMap && controlMap->IsMovementControlsEnabled() && player && player->Is3DLoaded();
+    const auto state = canDecide ? &GetSnapshot(player, *settings) : nullptr;
+
+    for (const auto& input : batchInputs) {
+        PAK_ZONE("ProcessEvent::Decide");
+        const ScopedTiming eventTiming(AttackStats::Timing::kEvent);
+
+        // Update state of combo keys and pending repeats
+        attackStateMachine.UpdateKeyState(input, settings->keyBindings);
+        const double now = GetTime();
+
+        if (!canDecide) {
+            if (statsEnabled && menuBlocked && input.IsDown() && settings->keyBindings.Get(input.keycode).IsPowerAttackKey()) stats->RecordOutcome(AttackOutcome::kMenuRejected);
+            if (recorder->IsRecording()) recorder->Record(now, input, {}, {}, menuBlocked ? kRecordMenuBlocked : kRecordNotReady, 0);
+            continue;
+        }
+
+        ActionList actions;
+        const auto decisionStart = recorder->IsRecording() ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+        const bool consumed = attackStateMachine.Process(input, now, *state, settings->keyBindings, settings->attackConfig, actions);
+        const auto decisionNs = recorder->IsRecording() ? std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - decisionStart).count() : 0;
+
+        if (!actions.empty() || actions.staminaRejected) QueueActions({ actions, input.keycode, now, received });
+        // Formatted only when trace is enabled, the file is written by the logger's thread
+        if (consumed) logger::trace("Key {} decided {} actions, outcome {}", input.keycode, actions.count, std::to_underlying(actions.outcome));
+        if (statsEnabled) stats->RecordOutcome(actions.outcome);
+
+        if (recorder->IsRecording()) {
+            recorder->Record(now, input, *state, actions, consumed ? kRecordConsumed : 0, static_cast<std::uint32_t>(decisionNs));
         }
     }
 
     return RE::BSEventNotifyControl::kContinue;
 }
 
-void InputEventHandler::PerformAction(RE::BGSAction* action, RE::Actor* player) {
-	if (action && player) {
-        std::unique_ptr<RE::TESActionData> data(RE::TESActionData::Create());
-        data->source = RE::NiPointer<RE::TESObjectREFR>(player);
-        data->action = action;
-        typedef bool func_t(RE::TESActionData*);
-        REL::Relocation<func_t> func{ RELOCATION_ID(40551, 41557) };
-        func(data.get());
-	}
+// Translates the button events of the chain to the unified keycode space, folded by AppendInput
+void InputEventHandler::CollectInputs(RE::InputEvent* event) {
+    PAK_ZONE("ProcessEvent::CollectInputs");
+    batchInputs.clear();
+    const auto keys = attackKeys.Get();
+    if (!keys) return;
+    if (movementStale.load(std::memory_order_relaxed) && movementStale.exchange(false, std::memory_order_acquire)) movement.Reset();
+
+    for (auto e{ event }; e != nullptr; e = e->next) {
+        TrackMovement(e, *keys);
+        const auto btn_event{ e->AsButtonEvent() };
+        if (!btn_event) continue;
+
+        const auto device{ btn_event->GetDevice() };
+        auto keycode{ btn_event->GetIDCode() };
+
+        using enum RE::INPUT_DEVICE;
+        if (device != kKeyboard && device != kGamepad && device != kMouse) continue;
+        if (device == kGamepad) keycode = SKSE::InputMap::GamepadMaskToKeycode(keycode);
+        if (device == kMouse) keycode = keycode + 256;
+
+        if (keycode >= kKeycodeCount || !keys->interestingKeys.test(keycode)) continue;
+
+        ButtonInput input;
+        input.device = device == kKeyboard ? InputDevice::kKeyboard : device == kMouse ? InputDevice::kMouse : InputDevice::kGamepad;
+        input.keycode = keycode;
+        input.value = btn_event->value;
+        input.heldDownSecs = btn_event->heldDownSecs;
+        if (keys->rightHandKeys.test(keycode)) input.attackHands |= kHandRight;
+        if (keys->leftHandKeys.test(keycode)) input.attackHands |= kHandLeft;
+        AppendInput(batchInputs, input);
+    }
 }
 
-bool InputEventHandler::PerformRightHandPA(RE::PlayerCharacter* player) {
-    bool isRightHandUnarmed = IsHandUnarmed(player, false);
-    bool bInJumpState = false;
-    player->GetGraphVariableBool("bInJumpState", bInJumpState);
-
-    if (HasEnoughStamina(player, true, false)) {
-        if (((isRightHandUnarmed || bInJumpState) && !Settings::usingMCO)) PerformAction(LARightHandAction, player);
-        PerformAction(PARightHandAction, player);
-        return true;
+// Followed on every event so the direction of a power attack is known without asking the game
+void InputEventHandler::TrackMovement(RE::InputEvent* event, const AttackKeyMap& keys) {
+    if (event->GetEventType() == RE::INPUT_EVENT_TYPE::kThumbstick) {
+        const auto stick = static_cast<RE::ThumbstickEvent*>(event);
+        if (stick->IsLeft()) movement.SetStick(stick->xValue, stick->yValue);
+        return;
     }
-    return false;
+
+    const auto btn_event{ event->AsButtonEvent() };
+    if (!btn_event || btn_event->GetDevice() != RE::INPUT_DEVICE::kKeyboard) return;
+    const auto key = std::ranges::find(keys.movementKeysKeyboard, btn_event->GetIDCode());
+    if (key == keys.movementKeysKeyboard.end()) return;
+
+    constexpr std::array directions{ MoveDirection::kForward, MoveDirection::kBack, MoveDirection::kLeft, MoveDirection::kRight };
+    movement.SetKey(directions[key - keys.movementKeysKeyboard.begin()], btn_event->IsPressed());
+}
+
+void InputEventHandler::SignalAttackWindow(AttackWindowEvent event) {
+    if (!attackWindowEvents.TryPush(event)) logger::warn("Attack window queue full, event {} dropped", std::to_underlying(event));
 }
 
-bool InputEventHandler::PerformLeftHandPA(RE::PlayerCharacter* player) {
-    bool isRightHandEquiped = HasEquipedWeapon(player, false);
-    bool isRightHandUnarmed = IsHandUnarmed(player, false);
-    bool isLeftHandEquiped = HasEquipedWeapon(player, true);
-    bool isLeftHandUnarmed = IsHandUnarmed(player, true);
-    bool bothHandsEquiped = isRightHandEquiped && isLeftHandEquiped;
-    bool bothHandsUnarmed = isRightHandUnarmed && isLeftHandUnarmed;
-    bool bothHandsWeaponsEquiped = bothHandsEquiped && !(isRightHandUnarmed || isLeftHandUnarmed);
-
-    if (HasEnoughStamina(player, false, true)) {
-        if (!(Settings::usingMCO && (bothHandsWeaponsEquiped || bothHandsUnarmed))) PerformAction(LALeftHandAction, player);
-        PerformAction(PALeftHandAction, player);
-        return true;
+void InputEventHandler::ApplyAttackWindows(RE::PlayerCharacter* player) {
+    AttackWindowEvent event;
+    if (!attackWindowEvents.TryPop(event)) return;
+    PAK_ZONE("ApplyAttackWindows");
+
+    const auto stats = AttackStats::GetSingleton();
+    const auto recorder = InputRecorder::GetSingleton();
+    const auto settings = Settings::Get();
+    const bool blocked = menuBlocking.load(std::memory_order_acquire);
+    do {
+        // Window state is followed even behind a menu, only the actions are dropped
+        const double now = GetTime();
+        const auto& state = GetSnapshot(player, *settings);
+        ActionList actions;
+        attackStateMachine.OnAttackWindow(event, now, state, settings->keyBindings, settings->attackConfig, actions);
+        if (recorder->IsRecording()) {
+            ButtonInput input;
+            input.keycode = std::to_underlying(event);
+            recorder->Record(now, input, state, actions, kRecordWindow | (blocked ? kRecordMenuBlocked : 0), 0);
+        }
+        if (blocked || actions.empty()) continue;
+        const bool performed = PerformActions(actions, player);
+        if (stats->IsEnabled()) {
+            stats->RecordOutcome(actions.outcome);
+            if (!performed) stats->RecordDispatchFailed();
+        }
+    } while (attackWindowEvents.TryPop(event));
+}
+
+void InputEventHandler::Update(RE::PlayerCharacter* player) {
+    ApplyAttackWindows(player);
+    // Consumed every frame, a retry only follows a graph event that came after the press
+    const bool attackAllowed = attackAllowedSignal.exchange(false, std::memory_order_acq_rel);
+    if (!attackStateMachine.HasPendingRepeats() || menuBlocking.load(std::memory_order_acquire)) return;
+    PAK_ZONE("InputEventHandler::Update");
+
+    const ScopedTiming updateTiming(AttackStats::Timing::kUpdate);
+    const auto stats = AttackStats::GetSingleton();
+    const auto recorder = InputRecorder::GetSingleton();
+    const auto settings = Settings::Get();
+    const double now = GetTime();
+    const auto& state = GetSnapshot(player, *settings);
+
+    ActionList actions;
+    attackStateMachine.Tick(now, state, settings->keyBindings, settings->attackConfig, actions);
+    if (recorder->IsRecording()) recorder->Record(now, {}, state, actions, kRecordTick, 0);
+    if (!actions.empty()) logger::trace("Repeat decided {} actions, outcome {}", actions.count, std::to_underlying(actions.outcome));
+    const bool performed = PerformActions(actions, player);
+    if (stats->IsEnabled()) {
+        stats->RecordOutcome(actions.outcome);
+        if (!performed) stats->RecordDispatchFailed();
+    }
+
+    // Buffered presses are only retried once the animation graph reported that attacking may be possible again
+    if (attackAllowed) {
+        const auto previousStats = attackStateMachine.GetBufferStats();
+        const double pressTime = attackStateMachine.GetBufferedTime();
+        ActionList retried;
+        attackStateMachine.RetryBuffered(state, settings->keyBindings, settings->attackConfig, retried);
+        if (!retried.empty()) {
+            const bool retryPerformed = PerformActions(retried, player);
+            attackStateMachine.ResolveBuffered(retryPerformed);
+            if (stats->IsEnabled()) {
+                stats->RecordOutcome(retried.outcome);
+                if (!retryPerformed) stats->RecordDispatchFailed();
+                else stats->RecordLatency(static_cast<std::uint64_t>((GetTime() - pressTime) * 1e9));
+            }
+            if (recorder->IsRecording()) recorder->Record(now, {}, state, retried, kRecordRetry | (retryPerformed ? 0 : kRecordDispatchFailed), 0);
+        }
+        if (const auto& bufferStats = attackStateMachine.GetBufferStats(); bufferStats.hits != previousStats.hits) {
+            logger::debug("Buffered power attack performed ({} hits, {} expired)", bufferStats.hits, bufferStats.expired);
+        }
     }
-    return false;
+    if (const auto& bufferStats = attackStateMachine.GetBufferStats(); bufferStats.expired != expiredReported) {
+        expiredReported = bufferStats.expired;
+        logger::debug("Buffered power attack expired ({} hits, {} expired)", bufferStats.hits, bufferStats.expired);
+    }
+    if (actions.staminaRejected) FlashHUDMeter(RE::ActorValue::kStamina);
 }
 
-bool InputEventHandler::PerformBothHandsPA(RE::PlayerCharacter* player) {
-    bool bInJumpState = false;
-    player->GetGraphVariableBool("bInJumpState", bInJumpState);
-    if (HasEnoughStamina(player, true, true)) {
-        if (bInJumpState) PerformAction(LABothHandsAction, player);
-        PerformAction(PABothHandsAction, player);
-        return true;
+void InputEventHandler::QueueActions(const QueuedDecision& decision) {
+    if (!decisionQueue.TryPush(decision)) {
+        logger::warn("Action queue full, actions dropped");
+        attackStateMachine.BufferPowerAttack(decision.keycode, decision.time, Settings::Get()->attackConfig);
+        return;
+    }
+    // One drain task at a time, it clears the flag before popping so nothing pushed meanwhile is missed
+    if (!drainScheduled.exchange(true, std::memory_order_acq_rel)) {
+        SKSE::GetTaskInterface()->AddTask([this] { DrainActions(); });
     }
-    return false;
 }
 
-void InputEventHandler::GetAttackKeys(){
-    auto* controlMap = RE::ControlMap::GetSingleton();
-    const auto* userEvents = RE::UserEvents::GetSingleton();
+void InputEventHandler::DrainActions() {
+    PAK_ZONE("DrainActions");
+    drainScheduled.store(false, std::memory_order_release);
+
+    const ScopedTiming drainTiming(AttackStats::Timing::kDrain);
+    const auto stats = AttackStats::GetSingleton();
+    const auto recorder = InputRecorder::GetSingleton();
+    const auto settings = Settings::Get();
+    const auto player = RE::PlayerCharacter::GetSingleton();
+
+    // The same hand and attack type is only performed once per drain, later copies share its result
+    std::array<bool, kActionSlots> dispatched{};
+    std::array<bool, kActionSlots> results{};
+    std::size_t depth = 0;
+    std::size_t collapsed = 0;
+
+    for (QueuedDecision decision; decisionQueue.TryPop(decision);) {
+        ++depth;
+        bool powerAttacksPerformed = true;
+        for (const auto& action : decision.actions) {
+            const auto slot = GetActionSlot(action);
+            if (slot >= kActionSlots) continue;
+            if (dispatched[slot]) {
+                ++collapsed;
+            } else {
+                dispatched[slot] = true;
+                results[slot] = PerformAction(action, player);
+            }
+            if (action.type == AttackType::kPower) powerAttacksPerformed &= results[slot];
+        }
+
+        // A press the game rejected (e.g. during recovery) is kept for a retry
+        if (!powerAttacksPerformed) {
+            attackStateMachine.BufferPowerAttack(decision.keycode, decision.time, settings->attackConfig);
+            logger::trace("Power attack of key {} rejected, buffered", decision.keycode);
+        }
+        if (decision.actions.staminaRejected) FlashHUDMeter(RE::ActorValue::kStamina);
 
-    rightAttackKeyKeyboard = controlMap->GetMappedKey(userEvents->rightAttack, RE::INPUT_DEVICE::kKeyboard);
-    rightAttackKeyMouse = controlMap->GetMappedKey(userEvents->rightAttack, RE::INPUT_DEVICE::kMouse);
-    rightAttackKeyGamepad = controlMap->GetMappedKey(userEvents->rightAttack, RE::INPUT_DEVICE::kGamepad);
-    rightAttackKeyGamepad = SKSE::InputMap::GamepadMaskToKeycode(rightAttackKeyGamepad);
+        if (stats->IsEnabled()) {
+            if (!powerAttacksPerformed) stats->RecordDispatchFailed();
+            else if (!decision.actions.empty() && decision.received != std::chrono::steady_clock::time_point{}) {
+                stats->RecordLatency(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - decision.received).count());
+            }
+        }
+        if (recorder->IsRecording()) {
+            ButtonInput input;
+            input.keycode = decision.keycode;
+            recorder->Record(decision.time, input, {}, decision.actions, kRecordDispatch | (powerAttacksPerformed ? 0 : kRecordDispatchFailed), 0);
+        }
+    }
 
-    leftAttackKeyKeyboard = controlMap->GetMappedKey(userEvents->leftAttack, RE::INPUT_DEVICE::kKeyboard);
-    leftAttackKeyMouse = controlMap->GetMappedKey(userEvents->leftAttack, RE::INPUT_DEVICE::kMouse);
-    leftAttackKeyGamepad = controlMap->GetMappedKey(userEvents->leftAttack, RE::INPUT_DEVICE::kGamepad);
-    leftAttackKeyGamepad = SKSE::InputMap::GamepadMaskToKeycode(leftAttackKeyGamepad);
+    if (stats->IsEnabled()) {
+        stats->RecordQueueDepth(depth);
+        stats->RecordCollapsedActions(collapsed);
+    }
 }
 
-bool InputEventHandler::HasEquipedWeapon(const RE::PlayerCharacter* player, bool leftHand) {
-    RE::TESObjectWEAP* akWeapon = reinterpret_cast<RE::TESObjectWEAP*>(player->GetEquippedObject(leftHand));
-    if ((leftHand && HasEquippedTwoHandedWeapon(player))) return false;
-    if (!akWeapon || (!akWeapon->IsBow() && !akWeapon->IsStaff() && !akWeapon->IsCrossbow() && akWeapon->IsWeapon())) return true;
-    return false;
+double InputEventHandler::GetTime() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
 
-bool InputEventHandler::IsHandUnarmed(const RE::PlayerCharacter* player, bool leftHand) {
-    RE::TESObjectWEAP* akWeapon = reinterpret_cast<RE::TESObjectWEAP*>(player->GetEquippedObject(leftHand));
-    if (!akWeapon || akWeapon->IsHandToHandMelee()) return true;
-    return false;
-}
+const PlayerCombatSnapshot& InputEventHandler::GetSnapshot(RE::PlayerCharacter* player, const SettingsSnapshot& settings) {
+    PAK_ZONE("GetSnapshot");
+    if (settings.attackConfig.requireStaminaPA) {
+        snapshot.stamina = player->AsActorValueOwner()->GetActorValue(RE::ActorValue::kStamina);
+    }
 
-bool InputEventHandler::HasEquippedTwoHandedWeapon(const RE::PlayerCharacter* player) {
-    const auto* rightHand = player->GetEquippedObject(false);
-    const auto* rightWeapon = rightHand ? rightHand->As<RE::TESObjectWEAP>() : nullptr;
-    return rightWeapon && (rightWeapon->IsTwoHandedAxe() || rightWeapon->IsTwoHandedSword());
+    // Cleared before refreshing so an invalidation that races with the refresh is not lost
+    if (!snapshotDirty.exchange(false, std::memory_order_acq_rel)) return snapshot;
+
+    const auto equipHandler = EquipEventHandler::GetSingleton();
+    const auto equipment = equipHandler->GetState();
+    snapshot.isRightHandEquiped = CanMeleeAttack(equipment.right);
+    snapshot.isRightHandUnarmed = IsUnarmed(equipment.right);
+    snapshot.isLeftHandEquiped = CanMeleeAttack(equipment.left);
+    snapshot.isLeftHandUnarmed = IsUnarmed(equipment.left);
+    snapshot.hasTwoHandedWeapon = equipment.right == HandClass::kTwoHanded;
+    // Profiles resolved with an older lookup are not applied, the refresh that follows a new lookup invalidates the snapshot again
+    const auto weaponProfiles = equipHandler->GetWeaponProfiles();
+    const bool profilesResolved = weaponProfiles && weaponProfiles->version == equipment.profileVersion;
+    snapshot.rightWeapon = profilesResolved ? weaponProfiles->settings->GetWeaponProfile(equipment.rightProfile) : WeaponProfile{};
+    snapshot.leftWeapon = profilesResolved ? weaponProfiles->settings->GetWeaponProfile(equipment.leftProfile) : WeaponProfile{};
+
+    snapshot.isBlocking = false;
+    snapshot.isAttacking = false;
+    snapshot.inJumpState = false;
+    player->GetGraphVariableBool("Isblocking", snapshot.isBlocking);
+    player->GetGraphVariableBool("IsAttacking", snapshot.isAttacking);
+    player->GetGraphVariableBool("bInJumpState", snapshot.inJumpState);
+
+    const auto playerState = player->AsActorState();
+    snapshot.canAttack = !player->IsInKillMove() && playerState->GetWeaponState() == RE::WEAPON_STATE::kDrawn &&
+                         playerState->GetSitSleepState() == RE::SIT_SLEEP_STATE::kNormal && playerState->GetKnockState() == RE::KNOCK_STATE_ENUM::kNormal &&
+                         playerState->GetFlyState() == RE::FLY_STATE::kNone;
+    return snapshot;
 }
 
-bool InputEventHandler::HasEnoughStamina(RE::PlayerCharacter* player, bool rightHand, bool leftHand) {
-    if (!Settings::requireStaminaPA) return true;
-    int staminaCost = Settings::staminaCost1H;
-    if (rightHand && leftHand) staminaCost = Settings::staminaCost1H*2;
-    else if (rightHand && !leftHand && HasEquippedTwoHandedWeapon(player)) staminaCost = Settings::staminaCost2H;
-    if (player->AsActorValueOwner()->GetActorValue(RE::ActorValue::kStamina) >= staminaCost) return true;
-    FlashHUDMeter(RE::ActorValue::kStamina);
-    return false;
+// Batched path, a light + power attack pair is dispatched in one call
+bool InputEventHandler::PerformActions(const ActionList& actions, RE::PlayerCharacter* player) {
+    bool powerAttacksPerformed = true;
+    for (const auto& action : actions) {
+        const bool performed = PerformAction(action, player);
+        if (action.type == AttackType::kPower) powerAttacksPerformed &= performed;
+    }
+    return powerAttacksPerformed;
 }
 
-void InputEventHandler::FlashHUDMeter(RE::ActorValue a_av) {
-    static REL::Relocation<decltype(FlashHUDMeter)> FlashHUDMenuMeter{RELOCATION_ID(51907, 52845)};
-    return FlashHUDMenuMeter(a_av);
+bool InputEventHandler::PerformAction(const AttackAction& action, RE::Actor* player) {
+    PAK_ZONE("PerformAction");
+    const auto bgsAction = GetAction(action);
+    if (!bgsAction || !player) return false;
+
+    // Set right before the action so the graph picks the matching directional power attack
+    if (action.type == AttackType::kPower && action.directions) {
+        const auto& directions = Settings::Get()->keyBindings.GetDirections(action.directions);
+        const auto direction = directions[std::to_underlying(movement.Resolve())];
+        if (direction != MoveDirection::kNeutral) player->SetGraphVariableFloat("Direction", GetGraphDirection(direction));
+    }
+
+    auto data = GetActionData(GetActionSlot(action));
+    data->source = RE::NiPointer<RE::TESObjectREFR>(player);
+    data->action = bgsAction;
+
+    using func_t = bool(RE::TESActionData*);
+    static REL::Relocation<func_t> func{ RELOCATION_ID(40551, 41557) };
+    const bool performed = func(data);
+
+    // Do not keep the player referenced between dispatches
+    data->source.reset();
+    return performed;
 }
 
-bool InputEventHandler::IsRightHandKey(const RE::INPUT_DEVICE device, const std::uint32_t key) const {
-    switch (device) {
-        case RE::INPUT_DEVICE::kKeyboard:
-            return key == rightAttackKeyKeyboard;
-        case RE::INPUT_DEVICE::kMouse:
-            return key-256 == rightAttackKeyMouse;
-        case RE::INPUT_DEVICE::kGamepad:
-            return key == rightAttackKeyGamepad;
-        default:
-            return false;
+RE::TESActionData* InputEventHandler::GetActionData(std::size_t slot) {
+    if (!actionDataDefaults) actionDataDefaults = RE::TESActionData::Create();
+    auto& data = actionData[slot];
+    if (!data) {
+        data = RE::TESActionData::Create();
+        logger::debug("Allocated action data for slot {} ({} allocations)", slot, ++actionDataAllocations);
     }
+    // Whatever the previous dispatch left behind (strings, flags, result) goes back to what the game's constructor sets
+    *data = *actionDataDefaults;
+    return data;
+}
+
+RE::BGSAction* InputEventHandler::GetAction(const AttackAction& action) const {
+    const auto slot = GetActionSlot(action);
+    return slot < kActionSlots ? attackActions[slot] : nullptr;
 }
 
-bool InputEventHandler::IsLeftHandKey(const RE::INPUT_DEVICE device, const std::uint32_t key) const {
-    switch (device) {
-        case RE::INPUT_DEVICE::kKeyboard:
-            return key == leftAttackKeyKeyboard;
-        case RE::INPUT_DEVICE::kMouse:
-            return key-256 == leftAttackKeyMouse;
-        case RE::INPUT_DEVICE::kGamepad:
-            return key == leftAttackKeyGamepad;
-        default:
-            return false;
+bool InputEventHandler::ResolveActions() {
+    bool allResolved = true;
+    for (std::size_t slot = 0; slot < kActionSlots; ++slot) {
+        const auto form = RE::TESForm::LookupByID(actionFormIDs[slot]);
+        attackActions[slot] = form ? form->As<RE::BGSAction>() : nullptr;
+        if (!attackActions[slot]) {
+            logger::error("Action {:X} not found", actionFormIDs[slot]);
+            allResolved = false;
+        }
     }
-}
\ No newline at end of file
+    return allResolved;
+}
+
+void InputEventHandler::RefreshAttackKeys() {
+    PAK_ZONE("RefreshAttackKeys");
+    const auto controlMap = RE::ControlMap::GetSingleton();
+    const auto userEvents = RE::UserEvents::GetSingleton();
+    if (!controlMap || !userEvents) return;
+
+    auto keys = std::make_unique<AttackKeyMap>();
+    keys->interestingKeys = Settings::Get()->keyBindings.GetBoundKeys();
+
+    // Same keycode space as the input events: mouse buttons after the keyboard, gamepad buttons after the mouse
+    auto mapKeys = [&](const RE::BSFixedString& userEvent, std::bitset<kKeycodeCount>& handKeys) {
+        const std::array mapped{
+            controlMap->GetMappedKey(userEvent, RE::INPUT_DEVICE::kKeyboard),
+            controlMap->GetMappedKey(userEvent, RE::INPUT_DEVICE::kMouse) + 256,
+            SKSE::InputMap::GamepadMaskToKeycode(controlMap->GetMappedKey(userEvent, RE::INPUT_DEVICE::kGamepad))
+        };
+        for (const auto key : mapped) {
+            if (key >= kKeycodeCount) continue;
+            handKeys.set(key);
+            keys->interestingKeys.set(key);
+        }
+    };
+    mapKeys(userEvents->rightAttack, keys->rightHandKeys);
+    mapKeys(userEvents->leftAttack, keys->leftHandKeys);
+
+    keys->movementKeysKeyboard = {
+        controlMap->GetMappedKey(userEvents->forward, RE::INPUT_DEVICE::kKeyboard),
+        controlMap->GetMappedKey(userEvents->back, RE::INPUT_DEVICE::kKeyboard),
+        controlMap->GetMappedKey(userEvents->strafeLeft, RE::INPUT_DEVICE::kKeyboard),
+        controlMap->GetMappedKey(userEvents->strafeRight, RE::INPUT_DEVICE::kKeyboard)
+    };
+
+    if (attackKeys.PublishIfChanged(std::move(keys))) logger::debug("Attack keys refreshed ({} maps)", attackKeys.GetPublishCount());
+}
+
+void InputEventHandler::FlashHUDMeter(RE::ActorValue a_av) {
+    static REL::Relocation<decltype(FlashHUDMeter)> FlashHUDMenuMeter{RELOCATION_ID(51907, 52845)};
+    return FlashHUDMenuMeter(a_av);
+}
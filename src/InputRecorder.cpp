@@ -0,0 +1,83 @@
+#include "InputRecorder.h"
+#include "Settings.h"
+
+InputRecorder* InputRecorder::GetSingleton()
+{
+    static InputRecorder instance;
+    return &instance;
+}
+
+InputRecorder::~InputRecorder() {
+    if (!flushThread.joinable()) return;
+    flushThread.request_stop();
+    flushThread.join();
+    // At process exit the flush thread may have been killed before its last drain, the ring is ours once it is joined
+    Drain();
+}
+
+void InputRecorder::Start() {
+    auto logsFolder = SKSE::log::log_directory();
+    if (!logsFolder) return;
+    auto recordingPath = *logsFolder / std::format("{}.rec", SKSE::PluginDeclaration::GetSingleton()->GetName());
+
+    file.open(recordingPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        logger::error("Could not open {} for input recording", recordingPath.string());
+        return;
+    }
+
+    RecordingHeader header;
+    // Settings reloaded during the session are not recorded, the replay uses the ones from the start
+    const auto settings = Settings::Get();
+    header.config = settings->attackConfig;
+    header.profileCount = static_cast<std::uint32_t>(settings->profiles.size());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(settings->profiles.data()), settings->profiles.size() * sizeof(BindingProfile));
+
+    ring = std::make_unique<SpscRing<InputRecord, 4096>>();
+    flushThread = std::jthread([this](std::stop_token stopToken) { FlushLoop(stopToken); });
+    logger::info("Recording input to {}", recordingPath.string());
+}
+
+void InputRecorder::Record(double time, const ButtonInput& input, const PlayerCombatSnapshot& state, const ActionList& actions, std::uint16_t flags, std::uint32_t decisionNs) {
+    InputRecord record;
+    record.time = time;
+    record.input = input;
+    record.state = state;
+    record.decisionNs = decisionNs;
+    record.flags = flags | (actions.staminaRejected ? kRecordStaminaRejected : 0);
+    record.actionCount = actions.count;
+    std::copy(actions.begin(), actions.end(), record.actions.begin());
+
+    if (!ring->TryPush(record)) droppedRecords.fetch_add(1, std::memory_order_relaxed);
+}
+
+void InputRecorder::FlushLoop(std::stop_token stopToken) {
+    std::uint32_t reportedDrops = 0;
+    std::mutex wakeLock;
+    std::condition_variable_any wake;
+    while (!stopToken.stop_requested()) {
+        // A stop request ends the wait right away
+        std::unique_lock lock(wakeLock);
+        wake.wait_for(lock, stopToken, 250ms, [] { return false; });
+        lock.unlock();
+
+        Drain();
+
+        if (const auto drops = droppedRecords.load(std::memory_order_relaxed); drops != reportedDrops) {
+            logger::warn("Input recording buffer full, {} records dropped so far", drops);
+            reportedDrops = drops;
+        }
+    }
+
+    // The last inputs before quitting are the ones a bug report needs
+    Drain();
+}
+
+void InputRecorder::Drain() {
+    InputRecord record;
+    while (ring->TryPop(record)) {
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    file.flush();
+}
@@ -1,7 +1,25 @@
+#include <AttackStats.h>
+#include <ConsoleCommands.h>
+#include <EventHandlers.h>
+#include <Hooks.h>
 #include <InputHandler.h>
+#include <InputRecorder.h>
 #include <Settings.h>
 
-// Registering events to load default attack keys from loadscreens and journal
+// File sink shared by the async logger and the synchronous one used at exit
+static std::shared_ptr<spdlog::sinks::basic_file_sink_mt> g_logFileSink;
+
+// Lines dropped since the last report because the log queue was full
+static void ReportDroppedLogs(spdlog::logger& log) {
+    const auto threadPool = spdlog::thread_pool();
+    if (!threadPool) return;
+    if (const auto dropped = threadPool->overrun_counter()) {
+        threadPool->reset_overrun_counter();
+        log.warn("{} log lines dropped, raise iLogQueueSize or lower sLogLevel", dropped);
+    }
+}
+
+// Registering events to reload the settings from loadscreens and journal, and to track menus that block attacks
 class MenuWatcher final : public RE::BSTEventSink<RE::MenuOpenCloseEvent>
 {
 public:
@@ -12,38 +30,151 @@ public:
         if (!a_event || a_event->menuName.empty())
             return RE::BSEventNotifyControl::kContinue;
 
+        // Keep track of open menus that block attacks so the input handler does not have to query them
+        if (a_event->opening) {
+            if (IsBlockingMenu(a_event->menuName) && std::ranges::find(blockingMenus, a_event->menuName) == blockingMenus.end()) {
+                blockingMenus.push_back(a_event->menuName);
+            }
+        } else {
+            std::erase(blockingMenus, a_event->menuName);
+        }
+        InputEventHandler::GetSingleton()->SetMenuBlocking(!blockingMenus.empty());
+
         if (a_event->menuName == RE::InterfaceStrings::GetSingleton()->loadingMenu && !a_event->opening) {
-            InputEventHandler::GetSingleton()->GetAttackKeys();
+            if (Settings::ReloadIfChanged()) OnSettingsReloaded();
+            ReportDroppedLogs(*spdlog::default_logger());
+            InputEventHandler::GetSingleton()->RefreshAttackKeys();
+            InputEventHandler::GetSingleton()->ResetMovement();
+            EquipEventHandler::GetSingleton()->QueueRefresh();
+            AnimationEventHandler::GetSingleton()->Register();
         }else if(a_event->menuName == RE::InterfaceStrings::GetSingleton()->journalMenu && !a_event->opening) {
-            InputEventHandler::GetSingleton()->GetAttackKeys();
+            // The INI can be edited with the game paused, the bound keys are part of the key map
+            if (Settings::ReloadIfChanged()) {
+                OnSettingsReloaded();
+                InputEventHandler::GetSingleton()->RefreshAttackKeys();
+            }
         }
 
         return RE::BSEventNotifyControl::kContinue;
     }
+
+private:
+    static bool IsBlockingMenu(const RE::BSFixedString& menuName)
+    {
+        if (menuName == "Dialogue Menu" || menuName == "Console" || menuName == "TweenMenu" || menuName == "LevelUp Menu")
+            return true;
+
+        const auto ui = RE::UI::GetSingleton();
+        const auto menu = ui ? ui->GetMenu(menuName) : nullptr;
+        using enum RE::UI_MENU_FLAGS;
+        return menu && menu->menuFlags.any(kPausesGame, kApplicationMenu, kInventoryItemMenu, kModal);
+    }
+
+    static void OnSettingsReloaded()
+    {
+        AttackStats::GetSingleton()->SetEnabled(Settings::enableStats);
+        EquipEventHandler::GetSingleton()->ResolveWeaponProfiles();
+    }
+
+    std::vector<RE::BSFixedString> blockingMenus;
 };
 
 static MenuWatcher g_menuWatcher;
 
+// The game has no remap event, but it toggles the user events whenever controls change hands (menus, remapping, loading),
+// so the key map is rebuilt then and only published when a mapping actually changed
+class ControlsWatcher final : public RE::BSTEventSink<RE::UserEventEnabled>
+{
+public:
+    RE::BSEventNotifyControl ProcessEvent(
+        const RE::UserEventEnabled* a_event,
+        RE::BSTEventSource<RE::UserEventEnabled>*) override
+    {
+        if (a_event) InputEventHandler::GetSingleton()->RefreshAttackKeys();
+        return RE::BSEventNotifyControl::kContinue;
+    }
+};
+
+static ControlsWatcher g_controlsWatcher;
+
+// Dumps the statistics and the dropped log lines when the game exits.
+// Runs from a static destructor at DLL detach, when the async logger's thread is already gone, so it writes to the file directly
+struct StatsReporter
+{
+    ~StatsReporter()
+    {
+        if (!g_logFileSink) return;
+        spdlog::logger exitLog("exit", g_logFileSink);
+        exitLog.set_level(Settings::logLevel);
+
+        ReportDroppedLogs(exitLog);
+        const auto stats = AttackStats::GetSingleton();
+        if (stats->IsEnabled()) {
+            for (const auto& line : stats->Summarize(false)) {
+                exitLog.info("{}", line);
+            }
+        }
+        exitLog.flush();
+    }
+};
+
+// Time the plugin adds to the game's startup, reported once data is loaded
+static std::chrono::steady_clock::duration g_startupTime{};
+
+static std::int64_t ElapsedUs(std::chrono::steady_clock::time_point start) {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    g_startupTime += elapsed;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
 
 void MessageHandler(SKSE::MessagingInterface::Message* message) {
     if (message->type == SKSE::MessagingInterface::kDataLoaded){
-        RE::BSInputDeviceManager::GetSingleton()->AddEventSink(InputEventHandler::GetSingleton());
-    }
-    if (auto ui = RE::UI::GetSingleton()) {
-        ui->AddEventSink(&g_menuWatcher);
+        auto start = std::chrono::steady_clock::now();
+        const bool actionsResolved = InputEventHandler::GetSingleton()->ResolveActions();
+        logger::info("Actions resolved in {} us", ElapsedUs(start));
+
+        // Without every action the plugin stays disabled: no hook, sinks or console commands
+        if (actionsResolved) {
+            start = std::chrono::steady_clock::now();
+            Hooks::Install();
+            logger::info("Hooks installed in {} us", ElapsedUs(start));
+
+            start = std::chrono::steady_clock::now();
+            RE::BSInputDeviceManager::GetSingleton()->AddEventSink(InputEventHandler::GetSingleton());
+            RE::ScriptEventSourceHolder::GetSingleton()->AddEventSink<RE::TESEquipEvent>(EquipEventHandler::GetSingleton());
+            if (const auto controlMap = RE::ControlMap::GetSingleton()) controlMap->AddEventSink<RE::UserEventEnabled>(&g_controlsWatcher);
+            if (const auto ui = RE::UI::GetSingleton()) ui->AddEventSink(&g_menuWatcher);
+            InputEventHandler::GetSingleton()->RefreshAttackKeys();
+            logger::info("Event sinks registered in {} us", ElapsedUs(start));
+
+            start = std::chrono::steady_clock::now();
+            EquipEventHandler::GetSingleton()->ResolveWeaponProfiles();
+            logger::info("Weapon overrides resolved in {} us", ElapsedUs(start));
+
+            ConsoleCommands::Register();
+        } else {
+            logger::error("Power attack actions are missing, plugin disabled");
+        }
+        logger::info("Startup time: {} us", std::chrono::duration_cast<std::chrono::microseconds>(g_startupTime).count());
     }
 }
 
 void InitializeLog() {
     auto logsFolder = SKSE::log::log_directory();
     if (!logsFolder) SKSE::stl::report_and_fail("SKSE log_directory not provided, logs disabled.");
+    Settings::LoadLogSettings();
     auto pluginName = SKSE::PluginDeclaration::GetSingleton()->GetName();
     auto logFilePath = *logsFolder / std::format("{}.log", pluginName);
-    auto fileLoggerPtr = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath.string(), true);
-    auto loggerPtr = std::make_shared<spdlog::logger>("log", std::move(fileLoggerPtr));
+    g_logFileSink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath.string(), true);
+
+    // Lines are formatted by the caller and written by a background thread, a full queue drops its oldest line instead of blocking the game
+    spdlog::init_thread_pool(Settings::logQueueSize, 1);
+    auto loggerPtr = std::make_shared<spdlog::async_logger>("log", g_logFileSink, spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
     spdlog::set_default_logger(std::move(loggerPtr));
-    spdlog::set_level(spdlog::level::trace);
-    spdlog::flush_on(spdlog::level::trace);
+    spdlog::set_level(Settings::logLevel);
+    spdlog::flush_on(Settings::flushLevel);
+    spdlog::flush_every(std::chrono::seconds(1));
 }
 
 SKSEPluginLoad(const SKSE::LoadInterface *skse) {
@@ -52,8 +183,14 @@ SKSEPluginLoad(const SKSE::LoadInterface *skse) {
 
     SKSE::Init(skse);
 
+    auto start = std::chrono::steady_clock::now();
     Settings::LoadSettings();
-    logger::info("Settings loaded...");
+    logger::info("Settings loaded in {} us", ElapsedUs(start));
+
+    AttackStats::GetSingleton()->SetEnabled(Settings::enableStats);
+    static StatsReporter statsReporter;
+
+    if (Settings::recordInput) InputRecorder::GetSingleton()->Start();
 
     SKSE::GetMessagingInterface()->RegisterListener(MessageHandler);
 
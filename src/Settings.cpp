@@ -1,62 +1,166 @@
 #include <Settings.h>
+#include <Profiling.h>
+#include <SettingsSchema.h>
+#include <SnapshotPublisher.h>
 
-int Settings::rightHandKey;
-int Settings::leftHandKey;
-int Settings::bothHandsKey;
-int Settings::comboKey;
+bool Settings::recordInput;
+bool Settings::enableStats;
+spdlog::level::level_enum Settings::logLevel = spdlog::level::info;
+spdlog::level::level_enum Settings::flushLevel = spdlog::level::warn;
+std::size_t Settings::logQueueSize = 8192;
 
-int Settings::rightHandKeyAlt1;
-int Settings::leftHandKeyAlt1;
-int Settings::bothHandsKeyAlt1;
-int Settings::comboKeyAlt1;
+static_assert(kKeycodeCount == SKSE::InputMap::kMaxMacros);
 
-int Settings::rightHandKeyAlt2;
-int Settings::leftHandKeyAlt2;
-int Settings::bothHandsKeyAlt2;
-int Settings::comboKeyAlt2;
+namespace
+{
+    constexpr auto path = L"Data/SKSE/Plugins/PowerAttackKey.ini";
 
-bool Settings::holdConsecutivePA;
-bool Settings::holdConsecutiveLA;
-float Settings::consecutiveAttacksDelay;
-bool Settings::consecutiveDualAttacks;
-bool Settings::usingMCO;
+    SnapshotPublisher<SettingsSnapshot> current;
+    std::filesystem::file_time_type lastWriteTime;
 
-bool Settings::requireStaminaPA;
-int Settings::staminaCost1H;
-int Settings::staminaCost2H;
+    using namespace SettingsSchema;
 
-void Settings::LoadSettings()
+    // Same numbering as SettingsSchema::kLogLevelNames
+    static_assert(spdlog::level::trace == 0 && spdlog::level::warn == 3 && spdlog::level::off == 6);
+
+    // Invalid values are reported with their section and replaced by their default
+    template <class Values>
+    auto ReportInvalid(std::string_view section)
+    {
+        return [section](const SettingSpec<Values>& spec, std::string_view text) {
+            const std::string_view defaultValue = *spec.defaultValue ? spec.defaultValue : "none";
+            if (spec.type == SettingType::kBool || spec.type == SettingType::kInt || spec.type == SettingType::kFloat) {
+                logger::warn("[{}] Invalid {} = {}, expected {} to {}, using {}", section, spec.name, text, spec.min, spec.max, defaultValue);
+            } else {
+                logger::warn("[{}] Invalid {} = {}, using {}", section, spec.name, text, defaultValue);
+            }
+        };
+    }
+
+    // Missing keys are added to the INI when addMissing is set. Returns true if a key was added, so the INI only needs to be written back then
+    bool LoadSettingsSection(CSimpleIniA& ini, SettingsValues& values, bool addMissing)
+    {
+        bool missing = false;
+        auto getValue = [&](const SettingsSpec& spec) {
+            const char* text = ini.GetValue("Settings", spec.name);
+            if (!text && addMissing) {
+                ini.SetValue("Settings", spec.name, spec.defaultValue);
+                missing = true;
+            }
+            return text;
+        };
+        LoadSchema(kSettingsSchema, values, getValue, ReportInvalid<SettingsValues>("Settings"));
+        return missing;
+    }
+
+    // Sections named <prefix><name> in file order, with their name
+    std::vector<std::pair<const char*, std::string_view>> GetSections(const CSimpleIniA& ini, std::string_view prefix)
+    {
+        CSimpleIniA::TNamesDepend sections;
+        ini.GetAllSections(sections);
+        sections.sort(CSimpleIniA::Entry::LoadOrder());
+
+        std::vector<std::pair<const char*, std::string_view>> result;
+        for (const auto& section : sections) {
+            const std::string_view name = section.pItem;
+            if (name.starts_with(prefix)) result.emplace_back(section.pItem, name.substr(prefix.size()));
+        }
+        return result;
+    }
+
+    // [Profile.Name] sections
+    void LoadProfiles(CSimpleIniA& ini, std::vector<BindingProfile>& profiles)
+    {
+        for (const auto& [section, name] : GetSections(ini, "Profile.")) {
+            BindingProfile profile;
+            LoadSchema(kProfileSchema, profile, [&](const ProfileSpec& spec) { return ini.GetValue(section, spec.name); }, ReportInvalid<BindingProfile>(section));
+            profiles.push_back(profile);
+            logger::info("Loaded binding profile {}", name);
+        }
+    }
+
+    // [Weapon.Key] sections
+    void LoadWeaponOverrides(CSimpleIniA& ini, std::vector<WeaponOverride>& overrides)
+    {
+        for (const auto& [section, name] : GetSections(ini, "Weapon.")) {
+            if (overrides.size() == kMaxWeaponProfiles) {
+                logger::warn("More than {} weapon overrides, {} is ignored", kMaxWeaponProfiles, name);
+                continue;
+            }
+            WeaponOverride weaponOverride{ std::string(name), {} };
+            LoadSchema(kWeaponSchema, weaponOverride.profile, [&](const WeaponSpec& spec) { return ini.GetValue(section, spec.name); },
+                       ReportInvalid<WeaponProfile>(section));
+            overrides.push_back(std::move(weaponOverride));
+        }
+    }
+}
+
+void Settings::LoadLogSettings()
 {
-    constexpr auto path = L"Data/SKSE/Plugins/PowerAttackKey.ini";
+    CSimpleIniA ini;
+    ini.SetUnicode();
+    ini.LoadFile(path);
+
+    SettingsValues values;
+    LoadSettingsSection(ini, values, false);
+    logLevel = static_cast<spdlog::level::level_enum>(values.logLevel);
+    flushLevel = static_cast<spdlog::level::level_enum>(values.flushLevel);
+    logQueueSize = values.logQueueSize;
+}
 
+void Settings::LoadSettings()
+{
+    PAK_ZONE("Settings::LoadSettings");
     CSimpleIniA ini;
     ini.SetUnicode();
     ini.LoadFile(path);
 
-    rightHandKey = std::stoi(ini.GetValue("Settings", "iRightHandKey", "45"));
-    leftHandKey = std::stoi(ini.GetValue("Settings", "iLeftHandKey", "-1"));
-    bothHandsKey = std::stoi(ini.GetValue("Settings", "iDualWieldKey", "-1"));
-    comboKey = std::stoi(ini.GetValue("Settings", "iComboKey", "-1"));
-
-    rightHandKeyAlt1 = std::stoi(ini.GetValue("Settings", "iRightHandKeyAlt1", "281"));
-    leftHandKeyAlt1 = std::stoi(ini.GetValue("Settings", "iLeftHandKeyAlt1", "-1"));
-    bothHandsKeyAlt1 = std::stoi(ini.GetValue("Settings", "iDualWieldKeyAlt1", "-1"));
-    comboKeyAlt1 = std::stoi(ini.GetValue("Settings", "iComboKeyAlt1", "-1"));
-
-    rightHandKeyAlt2 = std::stoi(ini.GetValue("Settings", "iRightHandKeyAlt2", "-1"));
-    leftHandKeyAlt2 = std::stoi(ini.GetValue("Settings", "iLeftHandKeyAlt2", "-1"));
-    bothHandsKeyAlt2 = std::stoi(ini.GetValue("Settings", "iDualWieldKeyAlt2", "-1"));
-    comboKeyAlt2 = std::stoi(ini.GetValue("Settings", "iComboKeyAlt2", "-1"));
-
-    holdConsecutivePA = std::stoi(ini.GetValue("Settings", "bConsecutivePowerAttacks", "0"));
-    holdConsecutiveLA = std::stoi(ini.GetValue("Settings", "bConsecutiveLightAttacks", "0"));
-    consecutiveAttacksDelay = std::stoi(ini.GetValue("Settings", "fConsecutiveAttacksDelay", "0.5"));
-    consecutiveDualAttacks = std::stoi(ini.GetValue("Settings", "bConsecutiveDualAttacks", "0"));
-    usingMCO = std::stoi(ini.GetValue("Settings", "bUsingMCO", "0"));
-
-    requireStaminaPA = std::stoi(ini.GetValue("Settings", "bPowerAttacksRequireStamina", "0"));
-    staminaCost1H = std::stoi(ini.GetValue("Settings", "iStaminaCost1H", "15"));
-    staminaCost2H = std::stoi(ini.GetValue("Settings", "iStaminaCost2H", "30"));
-
-    (void)ini.SaveFile(path);
-}
\ No newline at end of file
+    std::error_code error;
+    lastWriteTime = std::filesystem::last_write_time(path, error);
+
+    // A missing INI is generated from the schema defaults
+    SettingsValues values;
+    const bool missing = LoadSettingsSection(ini, values, true);
+
+    auto settings = std::make_unique<SettingsSnapshot>();
+    settings->attackConfig = values.attackConfig;
+
+    // The recorder is only started at load, changing this needs a restart
+    recordInput = values.recordInput;
+    enableStats = values.enableStats;
+
+    logLevel = static_cast<spdlog::level::level_enum>(values.logLevel);
+    flushLevel = static_cast<spdlog::level::level_enum>(values.flushLevel);
+    spdlog::set_level(logLevel);
+    spdlog::flush_on(flushLevel);
+
+    settings->profiles.assign(values.legacyProfiles.begin(), values.legacyProfiles.end());
+    LoadProfiles(ini, settings->profiles);
+    LoadWeaponOverrides(ini, settings->weaponOverrides);
+    if (!settings->keyBindings.Build(settings->profiles)) {
+        logger::warn("More than {} distinct chord keys, the profiles using the others are ignored", kMaxChordMaskKeys);
+    }
+
+    if (missing) {
+        (void)ini.SaveFile(path);
+        lastWriteTime = std::filesystem::last_write_time(path, error);
+    }
+
+    current.Publish(std::move(settings));
+}
+
+bool Settings::ReloadIfChanged()
+{
+    std::error_code error;
+    const auto writeTime = std::filesystem::last_write_time(path, error);
+    if (error || writeTime == lastWriteTime) return false;
+
+    LoadSettings();
+    logger::info("Settings reloaded");
+    return true;
+}
+
+const SettingsSnapshot* Settings::Get()
+{
+    return current.Get();
+}
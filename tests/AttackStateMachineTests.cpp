@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "AttackStateMachine.h"
+
+namespace
+{
+    constexpr std::uint32_t kAttackKey = 256;  // Left mouse button, mapped to the game's right hand attack
+
+    ButtonInput AttackKey(bool pressed, float heldDownSecs)
+    {
+        ButtonInput input;
+        input.device = InputDevice::kMouse;
+        input.keycode = kAttackKey;
+        input.value = pressed ? 1.0f : 0.0f;
+        input.heldDownSecs = heldDownSecs;
+        input.attackHands = kHandRight;
+        return input;
+    }
+
+    PlayerCombatSnapshot Attacking()
+    {
+        PlayerCombatSnapshot state;
+        state.canAttack = true;
+        state.isAttacking = true;
+        state.isRightHandEquiped = true;
+        return state;
+    }
+
+    // Holds the attack key from 0 with light attack repeats every 0.5s, frames are simulated at a fixed rate
+    class RepeatClock
+    {
+        public:
+            RepeatClock()
+            {
+                config.holdConsecutiveLA = true;
+                config.consecutiveAttacksDelay = 0.5f;
+                bindings.Build({});
+
+                ActionList actions;
+                stateMachine.UpdateKeyState(AttackKey(true, 0.0f), bindings);
+                stateMachine.Process(AttackKey(true, 0.0f), 0.0, state, bindings, config, actions);
+            }
+
+            // Times of the repeats performed by the frames in [from, until]
+            std::vector<double> Run(double fps, double from, double until)
+            {
+                std::vector<double> repeats;
+                // Frame times are computed, not accumulated, so the rate does not drift
+                for (auto frame = static_cast<long>(from * fps); frame / fps <= until; ++frame) {
+                    const double now = frame / fps;
+                    if (now < from) continue;
+                    if (Tick(now)) repeats.push_back(now);
+                }
+                return repeats;
+            }
+
+            bool Tick(double now)
+            {
+                ActionList actions;
+                stateMachine.Tick(now, state, bindings, config, actions);
+                return !actions.empty();
+            }
+
+            AttackStateMachine stateMachine;
+            KeyBindingTable bindings;
+            AttackConfig config;
+            PlayerCombatSnapshot state = Attacking();
+    };
+}
+
+// The repeat cadence follows the delay, not the frame rate
+TEST(RepeatTimerTest, CadenceIsFrameRateIndependent)
+{
+    for (const double fps : { 30.0, 60.0, 144.0 }) {
+        RepeatClock clock;
+        const auto repeats = clock.Run(fps, 0.0, 2.5);
+        ASSERT_EQ(repeats.size(), 5u) << fps << " fps";
+        for (std::size_t i = 0; i < repeats.size(); ++i) {
+            const double expected = 0.5 * (i + 1);
+            // Performed by the first frame at or after the deadline
+            EXPECT_GE(repeats[i], expected) << fps << " fps, repeat " << i;
+            EXPECT_LT(repeats[i], expected + 1.0 / fps) << fps << " fps, repeat " << i;
+        }
+    }
+}
+
+// Frame times that do not divide the delay still keep the cadence instead of adding up the late frames
+TEST(RepeatTimerTest, LateFramesDoNotDrift)
+{
+    RepeatClock clock;
+    const auto repeats = clock.Run(7.0, 0.0, 10.0);
+    ASSERT_EQ(repeats.size(), 20u);
+    EXPECT_LT(repeats.back(), 10.0 + 1.0 / 7.0);
+}
+
+TEST(RepeatTimerTest, ReleaseDropsTheTimer)
+{
+    RepeatClock clock;
+    ASSERT_EQ(clock.Run(60.0, 0.0, 1.2).size(), 2u);
+
+    clock.stateMachine.UpdateKeyState(AttackKey(false, 1.2f), clock.bindings);
+    EXPECT_FALSE(clock.stateMachine.HasPendingRepeats());
+    EXPECT_TRUE(clock.Run(60.0, 1.2, 3.0).empty());
+}
+
+// The timer keeps running while attacking is not possible, the overdue repeat fires once and the cadence restarts from there
+TEST(RepeatTimerTest, NoBurstAfterStall)
+{
+    RepeatClock clock;
+    ASSERT_EQ(clock.Run(60.0, 0.0, 1.0).size(), 2u);
+
+    // A 1.2s hitch, or a stagger that kept the player from attacking
+    clock.state.canAttack = false;
+    EXPECT_FALSE(clock.Tick(1.6));
+    clock.state.canAttack = true;
+
+    EXPECT_TRUE(clock.Tick(2.2));
+    EXPECT_FALSE(clock.Tick(2.2));
+    EXPECT_FALSE(clock.Tick(2.6));
+    EXPECT_TRUE(clock.Tick(2.7));
+}
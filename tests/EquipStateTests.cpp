@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include "EquipState.h"
+
+namespace
+{
+    // Stands in for the player's equipment, counts the hands that were looked at
+    struct MockEquipment
+    {
+        EquippedObject right;
+        EquippedObject left;
+        mutable int leftReads = 0;
+
+        EquippedObject GetEquippedObject(bool leftHand) const
+        {
+            if (!leftHand) return right;
+            ++leftReads;
+            return left;
+        }
+    };
+
+    EquippedObject Weapon(WeaponType type, std::uint8_t profile = 0)
+    {
+        return { .empty = false, .isWeapon = true, .weaponType = type, .profile = profile };
+    }
+
+    // Shield, spell, torch: equipped but not a weapon
+    EquippedObject Other()
+    {
+        return { .empty = false, .isWeapon = false };
+    }
+}
+
+TEST(EquipStateTest, WeaponTypes)
+{
+    EXPECT_EQ(ClassifyObject(Weapon(WeaponType::kOneHandSword)), HandClass::kOneHanded);
+    EXPECT_EQ(ClassifyObject(Weapon(WeaponType::kOneHandDagger)), HandClass::kOneHanded);
+    EXPECT_EQ(ClassifyObject(Weapon(WeaponType::kOneHandAxe)), HandClass::kOneHanded);
+    EXPECT_EQ(ClassifyObject(Weapon(WeaponType::kOneHandMace)), HandClass::kOneHanded);
+    EXPECT_EQ(ClassifyObject(Weapon(WeaponType::kTwoHandSword)), HandClass::kTwoHanded);
+    EXPECT_EQ(ClassifyObject(Weapon(WeaponType::kTwoHandAxe)), HandClass::kTwoHanded);
+    EXPECT_EQ(ClassifyObject(Weapon(WeaponType::kBow)), HandClass::kRanged);
+    EXPECT_EQ(ClassifyObject(Weapon(WeaponType::kCrossbow)), HandClass::kRanged);
+    EXPECT_EQ(ClassifyObject(Weapon(WeaponType::kStaff)), HandClass::kStaff);
+    EXPECT_EQ(ClassifyObject(Other()), HandClass::kNone);
+}
+
+// Hand to hand weapons attack like empty hands
+TEST(EquipStateTest, EmptyHandsAndHandToHand)
+{
+    const MockEquipment empty;
+    const auto emptyState = ClassifyEquipment(empty);
+    EXPECT_EQ(emptyState.right, HandClass::kUnarmed);
+    EXPECT_EQ(emptyState.left, HandClass::kUnarmed);
+    EXPECT_TRUE(IsUnarmed(emptyState.right));
+    EXPECT_TRUE(CanMeleeAttack(emptyState.left));
+
+    const MockEquipment fists{ .right = Weapon(WeaponType::kHandToHandMelee, 2), .left = Weapon(WeaponType::kHandToHandMelee, 3) };
+    const auto fistsState = ClassifyEquipment(fists);
+    EXPECT_EQ(fistsState.right, HandClass::kUnarmed);
+    EXPECT_EQ(fistsState.left, HandClass::kUnarmed);
+    EXPECT_EQ(fistsState.rightProfile, 2);
+    EXPECT_EQ(fistsState.leftProfile, 3);
+}
+
+// The left hand of a two handed weapon is never looked at, whatever the game reports for it
+TEST(EquipStateTest, TwoHandedTakesTheLeftHand)
+{
+    const MockEquipment greatsword{ .right = Weapon(WeaponType::kTwoHandSword, 4), .left = Weapon(WeaponType::kTwoHandSword, 4) };
+    const auto state = ClassifyEquipment(greatsword);
+    EXPECT_EQ(state.right, HandClass::kTwoHanded);
+    EXPECT_EQ(state.left, HandClass::kNone);
+    EXPECT_EQ(state.rightProfile, 4);
+    EXPECT_EQ(state.leftProfile, 0);
+    EXPECT_EQ(greatsword.leftReads, 0);
+    EXPECT_TRUE(CanMeleeAttack(state.right));
+    EXPECT_FALSE(CanMeleeAttack(state.left));
+}
+
+TEST(EquipStateTest, RangedAndStaves)
+{
+    const MockEquipment bow{ .right = Weapon(WeaponType::kBow) };
+    EXPECT_EQ(ClassifyEquipment(bow).right, HandClass::kRanged);
+    EXPECT_EQ(bow.leftReads, 1);
+
+    const MockEquipment crossbow{ .right = Weapon(WeaponType::kCrossbow) };
+    EXPECT_FALSE(CanMeleeAttack(ClassifyEquipment(crossbow).right));
+
+    const MockEquipment staves{ .right = Weapon(WeaponType::kStaff), .left = Weapon(WeaponType::kStaff) };
+    const auto state = ClassifyEquipment(staves);
+    EXPECT_EQ(state.right, HandClass::kStaff);
+    EXPECT_EQ(state.left, HandClass::kStaff);
+    EXPECT_FALSE(CanMeleeAttack(state.left));
+}
+
+// A shield or a spell in the left hand does not attack, the weapon in the right hand still does
+TEST(EquipStateTest, ShieldAndSpell)
+{
+    const MockEquipment swordAndShield{ .right = Weapon(WeaponType::kOneHandSword, 1), .left = Other() };
+    const auto state = ClassifyEquipment(swordAndShield);
+    EXPECT_EQ(state.right, HandClass::kOneHanded);
+    EXPECT_EQ(state.left, HandClass::kNone);
+    EXPECT_EQ(state.rightProfile, 1);
+    EXPECT_FALSE(CanMeleeAttack(state.left));
+    EXPECT_FALSE(IsUnarmed(state.left));
+
+    const MockEquipment spells{ .right = Other(), .left = Other() };
+    const auto spellState = ClassifyEquipment(spells);
+    EXPECT_EQ(spellState.right, HandClass::kNone);
+    EXPECT_EQ(spellState.left, HandClass::kNone);
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "InputBatch.h"
+
+namespace
+{
+    ButtonInput Input(InputDevice device, std::uint32_t keycode, float value, float heldDownSecs, std::uint8_t attackHands = kHandNone)
+    {
+        ButtonInput input;
+        input.device = device;
+        input.keycode = keycode;
+        input.value = value;
+        input.heldDownSecs = heldDownSecs;
+        input.attackHands = attackHands;
+        return input;
+    }
+
+    std::vector<ButtonInput> Fold(const std::vector<ButtonInput>& chain)
+    {
+        std::vector<ButtonInput> batch;
+        for (const auto& input : chain) AppendInput(batch, input);
+        return batch;
+    }
+
+    // The decision loop of the input sink: every input of the batch is seen, whatever the previous one returned
+    void Decide(AttackStateMachine& stateMachine, const std::vector<ButtonInput>& batch, const PlayerCombatSnapshot& state, const KeyBindingTable& bindings,
+                const AttackConfig& config, std::vector<ActionList>& decided)
+    {
+        for (const auto& input : batch) {
+            stateMachine.UpdateKeyState(input, bindings);
+            ActionList actions;
+            stateMachine.Process(input, 0.0, state, bindings, config, actions);
+            decided.push_back(actions);
+        }
+    }
+}
+
+TEST(InputBatchTest, HeldFloodIsCoalesced)
+{
+    std::vector<ButtonInput> chain{ Input(InputDevice::kGamepad, 281, 1.0f, 0.0f) };
+    for (int frame = 1; frame <= 100; ++frame) chain.push_back(Input(InputDevice::kGamepad, 281, 1.0f, frame * 0.01f));
+    chain.push_back(Input(InputDevice::kGamepad, 281, 0.0f, 1.01f));
+
+    const auto batch = Fold(chain);
+    ASSERT_EQ(batch.size(), 3u);
+    EXPECT_TRUE(batch[0].IsDown());
+    EXPECT_TRUE(batch[1].IsHeld());
+    EXPECT_FLOAT_EQ(batch[1].heldDownSecs, 1.0f);
+    EXPECT_TRUE(batch[2].IsUp());
+}
+
+// Each key folds its own held events, edges of every device keep their order
+TEST(InputBatchTest, MixedDevicesKeepEdgeOrder)
+{
+    const std::vector<ButtonInput> chain{
+        Input(InputDevice::kKeyboard, 42, 1.0f, 0.1f),
+        Input(InputDevice::kMouse, 256, 1.0f, 0.0f, kHandRight),
+        Input(InputDevice::kGamepad, 280, 1.0f, 0.2f, kHandLeft),
+        Input(InputDevice::kKeyboard, 42, 1.0f, 0.2f),
+        Input(InputDevice::kMouse, 256, 1.0f, 0.1f, kHandRight),
+        Input(InputDevice::kGamepad, 280, 1.0f, 0.3f, kHandLeft),
+        Input(InputDevice::kMouse, 256, 1.0f, 0.2f, kHandRight),
+        Input(InputDevice::kKeyboard, 45, 1.0f, 0.0f),
+        Input(InputDevice::kGamepad, 280, 0.0f, 0.4f, kHandLeft),
+        Input(InputDevice::kMouse, 256, 1.0f, 0.3f, kHandRight),
+    };
+
+    const auto batch = Fold(chain);
+    ASSERT_EQ(batch.size(), 6u);
+    EXPECT_EQ(batch[0].keycode, 42u);
+    EXPECT_FLOAT_EQ(batch[0].heldDownSecs, 0.2f);
+    EXPECT_EQ(batch[1].keycode, 256u);
+    EXPECT_TRUE(batch[1].IsDown());
+    EXPECT_EQ(batch[2].keycode, 280u);
+    EXPECT_FLOAT_EQ(batch[2].heldDownSecs, 0.3f);
+    // The held events after the down of 256 fold together, but never into the down itself
+    EXPECT_EQ(batch[3].keycode, 256u);
+    EXPECT_FLOAT_EQ(batch[3].heldDownSecs, 0.3f);
+    EXPECT_EQ(batch[3].device, InputDevice::kMouse);
+    EXPECT_EQ(batch[3].attackHands, kHandRight);
+    EXPECT_EQ(batch[4].keycode, 45u);
+    EXPECT_TRUE(batch[4].IsDown());
+    EXPECT_EQ(batch[5].keycode, 280u);
+    EXPECT_TRUE(batch[5].IsUp());
+}
+
+// Held events on both sides of an up are separate presses and are not folded together
+TEST(InputBatchTest, HeldEventsDoNotFoldAcrossEdges)
+{
+    const std::vector<ButtonInput> chain{
+        Input(InputDevice::kKeyboard, 45, 1.0f, 0.5f),
+        Input(InputDevice::kKeyboard, 45, 0.0f, 0.6f),
+        Input(InputDevice::kKeyboard, 45, 1.0f, 0.0f),
+        Input(InputDevice::kKeyboard, 45, 1.0f, 0.1f),
+    };
+    EXPECT_EQ(Fold(chain).size(), 4u);
+}
+
+// A press that decided a power attack does not hide its release later in the same batch
+TEST(InputBatchTest, KeyUpAfterConsumedInput)
+{
+    std::vector<BindingProfile> profiles(2);
+    profiles[0].rightHandKey = 45;
+    profiles[1].leftHandKey = 45;
+    profiles[1].chordKeys[0] = 42;
+    KeyBindingTable bindings;
+    ASSERT_TRUE(bindings.Build(profiles));
+    AttackConfig config;
+    config.holdConsecutivePA = true;
+    PlayerCombatSnapshot state;
+    state.canAttack = true;
+    state.isRightHandEquiped = true;
+    state.isLeftHandEquiped = true;
+
+    const auto batch = Fold({
+        Input(InputDevice::kKeyboard, 45, 1.0f, 0.0f),
+        Input(InputDevice::kKeyboard, 45, 1.0f, 0.01f),
+        Input(InputDevice::kKeyboard, 45, 0.0f, 0.02f),
+    });
+    ASSERT_EQ(batch.size(), 3u);
+
+    AttackStateMachine stateMachine;
+    std::vector<ActionList> decided;
+    Decide(stateMachine, batch, state, bindings, config, decided);
+    ASSERT_FALSE(decided[0].empty());
+    EXPECT_EQ(decided[0].outcome, AttackOutcome::kPowerAttack);
+    // The release dropped the repeat the press armed
+    EXPECT_FALSE(stateMachine.HasPendingRepeats());
+
+    // Same for inputs consumed because the player could not attack, the chord key is released in the same batch
+    state.canAttack = false;
+    decided.clear();
+    Decide(stateMachine, Fold({
+        Input(InputDevice::kKeyboard, 42, 1.0f, 0.0f),
+        Input(InputDevice::kKeyboard, 45, 1.0f, 0.0f),
+        Input(InputDevice::kKeyboard, 45, 0.0f, 0.01f),
+        Input(InputDevice::kKeyboard, 42, 0.0f, 0.02f),
+    }), state, bindings, config, decided);
+    EXPECT_EQ(decided[1].outcome, AttackOutcome::kStateRejected);
+
+    state.canAttack = true;
+    decided.clear();
+    Decide(stateMachine, { Input(InputDevice::kKeyboard, 45, 1.0f, 0.0f) }, state, bindings, config, decided);
+    ASSERT_FALSE(decided[0].empty());
+    EXPECT_EQ(decided[0].begin()->hand, kHandRight);
+}
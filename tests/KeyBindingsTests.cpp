@@ -0,0 +1,484 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "AttackStateMachine.h"
+
+namespace
+{
+    // The primary, Alt1 and Alt2 key sets of the old INI, each one with its combo key
+    struct LegacySlot
+    {
+        int rightHandKey = -1;
+        int leftHandKey = -1;
+        int bothHandsKey = -1;
+        int comboKey = -1;
+    };
+
+    using LegacySlots = std::array<LegacySlot, 3>;
+
+    // The comparison chain ProcessEvent used before the binding table, kept verbatim as the reference.
+    // Returns the hand of the power attack performed on a key press, kHandNone if there is none.
+    // fixedPrecedence applies !isKeyWithCombo to every dual wield fallback instead of Alt2 only, as the table does
+    std::uint8_t LegacyPowerAttack(const LegacySlots& slots, const std::array<bool, 3>& comboActive, int keycode, const PlayerCombatSnapshot& state,
+                                   bool fixedPrecedence = false)
+    {
+        const auto& primary = slots[0];
+        const auto& alt1 = slots[1];
+        const auto& alt2 = slots[2];
+        const bool isRightHandEquiped = state.isRightHandEquiped;
+        const bool isLeftHandEquiped = state.isLeftHandEquiped;
+        const bool isLeftHandUnarmed = state.isLeftHandUnarmed;
+        const bool isRightHandUnarmed = state.isRightHandUnarmed;
+
+        const bool isUsingCombo = comboActive[0] && !(comboActive[1] || comboActive[2]);
+        const bool isUsingComboAlt1 = comboActive[1] && !(comboActive[0] || comboActive[2]);
+        const bool isUsingComboAlt2 = comboActive[2] && !(comboActive[0] || comboActive[1]);
+        bool isKeyWithCombo = false;
+
+        if (isUsingCombo && primary.comboKey > 0) {
+            if (keycode == primary.rightHandKey && isRightHandEquiped) {
+                return kHandRight;
+            } else if (keycode == primary.leftHandKey && isLeftHandEquiped && (!isLeftHandUnarmed || (isLeftHandUnarmed && isRightHandUnarmed))) {
+                return kHandLeft;
+            } else if (keycode == primary.bothHandsKey) {
+                return kHandBoth;
+            }
+            if (keycode == primary.rightHandKey || keycode == primary.leftHandKey || keycode == primary.bothHandsKey) isKeyWithCombo = true;
+        }
+        if (isUsingComboAlt1 && alt1.comboKey > 0) {
+            if (keycode == alt1.rightHandKey && isRightHandEquiped) {
+                return kHandRight;
+            } else if (keycode == alt1.leftHandKey && isLeftHandEquiped && (!isLeftHandUnarmed || (isLeftHandUnarmed && isRightHandUnarmed))) {
+                return kHandLeft;
+            } else if (keycode == alt1.bothHandsKey) {
+                return kHandBoth;
+            }
+            if (keycode == alt1.rightHandKey || keycode == alt1.leftHandKey || keycode == alt1.bothHandsKey) isKeyWithCombo = true;
+        }
+        if (isUsingComboAlt2 && alt2.comboKey > 0) {
+            if (keycode == alt2.rightHandKey && isRightHandEquiped) {
+                return kHandRight;
+            } else if (keycode == alt2.leftHandKey && isLeftHandEquiped && (!isLeftHandUnarmed || (isLeftHandUnarmed && isRightHandUnarmed))) {
+                return kHandLeft;
+            } else if (keycode == alt2.bothHandsKey) {
+                return kHandBoth;
+            }
+            if (keycode == alt2.rightHandKey || keycode == alt2.leftHandKey || keycode == alt2.bothHandsKey) isKeyWithCombo = true;
+        }
+
+        if (((keycode == primary.rightHandKey && primary.comboKey <= 0) ||
+             (keycode == alt1.rightHandKey && alt1.comboKey <= 0) ||
+             (keycode == alt2.rightHandKey && alt2.comboKey <= 0)) && isRightHandEquiped && !isKeyWithCombo) {
+            return kHandRight;
+        } else if (((keycode == primary.leftHandKey && primary.comboKey <= 0) ||
+                    (keycode == alt1.leftHandKey && alt1.comboKey <= 0) ||
+                    (keycode == alt2.leftHandKey && alt2.comboKey <= 0)) &&
+                   isLeftHandEquiped && (!isLeftHandUnarmed || (isLeftHandUnarmed && isRightHandUnarmed)) && !isKeyWithCombo) {
+            return kHandLeft;
+        } else if (!fixedPrecedence && (((keycode == primary.bothHandsKey && primary.comboKey <= 0)) ||
+                                        (keycode == alt1.bothHandsKey && alt1.comboKey <= 0) ||
+                                        (keycode == alt2.bothHandsKey && alt2.comboKey <= 0) && !isKeyWithCombo)) {
+            return kHandBoth;
+        } else if (fixedPrecedence && ((keycode == primary.bothHandsKey && primary.comboKey <= 0) ||
+                                       (keycode == alt1.bothHandsKey && alt1.comboKey <= 0) ||
+                                       (keycode == alt2.bothHandsKey && alt2.comboKey <= 0)) && !isKeyWithCombo) {
+            return kHandBoth;
+        }
+        return kHandNone;
+    }
+
+    std::vector<BindingProfile> ToProfiles(const LegacySlots& slots)
+    {
+        std::vector<BindingProfile> profiles(slots.size());
+        for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+            profiles[slot].rightHandKey = slots[slot].rightHandKey;
+            profiles[slot].leftHandKey = slots[slot].leftHandKey;
+            profiles[slot].bothHandsKey = slots[slot].bothHandsKey;
+            profiles[slot].chordKeys[0] = slots[slot].comboKey;
+        }
+        return profiles;
+    }
+
+    ButtonInput Press(std::uint32_t keycode, bool pressed)
+    {
+        ButtonInput input;
+        input.keycode = keycode;
+        input.value = pressed ? 1.0f : 0.0f;
+        input.heldDownSecs = pressed ? 0.0f : 0.1f;
+        return input;
+    }
+
+    std::uint8_t PowerAttackHand(const ActionList& actions)
+    {
+        for (const auto& action : actions) {
+            if (action.type == AttackType::kPower) return action.hand;
+        }
+        return kHandNone;
+    }
+
+    // Press and release of a key, returns the hand of the power attack it decided
+    std::uint8_t PressAndRelease(AttackStateMachine& stateMachine, const KeyBindingTable& bindings, std::uint32_t keycode, double now,
+                                 const PlayerCombatSnapshot& state, const AttackConfig& config = {})
+    {
+        ActionList actions;
+        stateMachine.UpdateKeyState(Press(keycode, true), bindings);
+        stateMachine.Process(Press(keycode, true), now, state, bindings, config, actions);
+        stateMachine.UpdateKeyState(Press(keycode, false), bindings);
+        return PowerAttackHand(actions);
+    }
+
+    PlayerCombatSnapshot DualWielding()
+    {
+        PlayerCombatSnapshot state;
+        state.canAttack = true;
+        state.isRightHandEquiped = true;
+        state.isLeftHandEquiped = true;
+        return state;
+    }
+
+    // Attack keys and combo keys come from separate pools, sharing a key between both roles was never supported
+    LegacySlots RandomSlots(std::mt19937& random)
+    {
+        std::uniform_int_distribution<int> attackKey(0, 5);
+        std::uniform_int_distribution<int> comboKey(0, 3);
+        auto pick = [&](std::uniform_int_distribution<int>& pool, int first) {
+            const int index = pool(random);
+            return index == 0 ? -1 : first + index;
+        };
+
+        LegacySlots slots;
+        std::array<bool, 4> usedCombos{};
+        for (auto& slot : slots) {
+            slot.rightHandKey = pick(attackKey, 10);
+            slot.leftHandKey = pick(attackKey, 10);
+            slot.bothHandsKey = pick(attackKey, 10);
+            // Two sets with the same combo key never both counted as active in the old chain
+            const int combo = pick(comboKey, 40);
+            if (combo > 0 && !usedCombos[combo - 40]) {
+                usedCombos[combo - 40] = true;
+                slot.comboKey = combo;
+            }
+        }
+        return slots;
+    }
+}
+
+// Replays random key streams through the old chain and the table, the only accepted difference is the dual wield precedence fix
+TEST(KeyBindingsTest, TableMatchesLegacyChain)
+{
+    std::mt19937 random(1234);
+    std::size_t presses = 0;
+    std::size_t divergences = 0;
+
+    for (int round = 0; round < 2000; ++round) {
+        const auto slots = RandomSlots(random);
+        const auto profiles = ToProfiles(slots);
+        KeyBindingTable bindings;
+        ASSERT_TRUE(bindings.Build(profiles));
+
+        PlayerCombatSnapshot state;
+        state.canAttack = true;
+        AttackConfig config;
+        AttackStateMachine stateMachine;
+        std::array<bool, 3> comboActive{};
+
+        for (int event = 0; event < 50; ++event) {
+            state.isRightHandEquiped = random() % 4 != 0;
+            state.isLeftHandEquiped = random() % 4 != 0;
+            state.isRightHandUnarmed = random() % 3 == 0;
+            state.isLeftHandUnarmed = random() % 3 == 0;
+
+            // Combo keys toggle, attack keys are pressed and released right away
+            if (random() % 3 == 0) {
+                const auto keycode = static_cast<std::uint32_t>(41 + random() % 3);
+                const bool pressed = random() % 2 == 0;
+                for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+                    if (slots[slot].comboKey == static_cast<int>(keycode)) comboActive[slot] = pressed;
+                }
+                stateMachine.UpdateKeyState(Press(keycode, pressed), bindings);
+                continue;
+            }
+
+            const auto keycode = static_cast<std::uint32_t>(11 + random() % 5);
+            const double now = event;
+            ActionList actions;
+            stateMachine.UpdateKeyState(Press(keycode, true), bindings);
+            stateMachine.Process(Press(keycode, true), now, state, bindings, config, actions);
+            stateMachine.UpdateKeyState(Press(keycode, false), bindings);
+            ++presses;
+
+            const auto table = PowerAttackHand(actions);
+            const auto legacy = LegacyPowerAttack(slots, comboActive, static_cast<int>(keycode), state);
+            ASSERT_EQ(table, LegacyPowerAttack(slots, comboActive, static_cast<int>(keycode), state, true)) << "key " << keycode << " round " << round;
+            if (table != legacy) {
+                // The fix can only ever drop a dual wield fallback
+                ASSERT_EQ(legacy, kHandBoth);
+                ASSERT_EQ(table, kHandNone);
+                ++divergences;
+            }
+        }
+    }
+    EXPECT_GT(presses, 50000u);
+    EXPECT_GT(divergences, 0u);
+}
+
+// The documented divergence: a key bound with its combo held no longer falls back to an unchorded dual wield bind of another set
+TEST(KeyBindingsTest, DualWieldFallbackRespectsHeldCombo)
+{
+    LegacySlots slots;
+    slots[0].rightHandKey = 45;
+    slots[0].comboKey = 42;
+    slots[1].bothHandsKey = 45;
+
+    PlayerCombatSnapshot state;
+    state.canAttack = true;
+    state.isRightHandEquiped = false;
+    state.isLeftHandEquiped = true;
+
+    // The old chain only guarded the Alt2 dual wield fallback, so Alt1 still fired
+    EXPECT_EQ(LegacyPowerAttack(slots, { true, false, false }, 45, state), kHandBoth);
+
+    const auto profiles = ToProfiles(slots);
+    KeyBindingTable bindings;
+    ASSERT_TRUE(bindings.Build(profiles));
+    AttackStateMachine stateMachine;
+    AttackConfig config;
+    stateMachine.UpdateKeyState(Press(42, true), bindings);
+
+    ActionList actions;
+    stateMachine.UpdateKeyState(Press(45, true), bindings);
+    stateMachine.Process(Press(45, true), 0.0, state, bindings, config, actions);
+    EXPECT_EQ(PowerAttackHand(actions), kHandNone);
+
+    // Without the combo the dual wield bind still works
+    AttackStateMachine released;
+    ActionList fallback;
+    released.UpdateKeyState(Press(45, true), bindings);
+    released.Process(Press(45, true), 0.0, state, bindings, config, fallback);
+    EXPECT_EQ(PowerAttackHand(fallback), kHandBoth);
+}
+
+TEST(KeyBindingsTest, OutOfRangeKeysAreUnbound)
+{
+    std::vector<BindingProfile> profiles(1);
+    profiles[0].rightHandKey = static_cast<int>(kKeycodeCount);
+    profiles[0].leftHandKey = -1;
+    KeyBindingTable bindings;
+    ASSERT_TRUE(bindings.Build(profiles));
+    EXPECT_FALSE(bindings.Get(kKeycodeCount).IsPowerAttackKey());
+    EXPECT_TRUE(bindings.GetBoundKeys().none());
+}
+
+// A chord profile only matches when exactly its chord keys are held
+TEST(KeyBindingsTest, ChordRequiresExactHeldKeys)
+{
+    std::vector<BindingProfile> profiles(3);
+    profiles[0].rightHandKey = 45;
+    profiles[0].chordKeys = { 42, -1, -1, -1 };
+    profiles[1].leftHandKey = 45;
+    profiles[1].chordKeys = { 42, 29, -1, -1 };
+    profiles[2].bothHandsKey = 46;
+    profiles[2].chordKeys = { 56, -1, -1, -1 };
+    KeyBindingTable bindings;
+    ASSERT_TRUE(bindings.Build(profiles));
+    const auto state = DualWielding();
+
+    AttackStateMachine stateMachine;
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 0.0, state), kHandNone);
+
+    stateMachine.UpdateKeyState(Press(42, true), bindings);
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 1.0, state), kHandRight);
+
+    stateMachine.UpdateKeyState(Press(29, true), bindings);
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 2.0, state), kHandLeft);
+
+    // A superset of both chords matches neither
+    stateMachine.UpdateKeyState(Press(56, true), bindings);
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 3.0, state), kHandNone);
+
+    stateMachine.UpdateKeyState(Press(42, false), bindings);
+    stateMachine.UpdateKeyState(Press(56, false), bindings);
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 4.0, state), kHandNone);
+}
+
+// A chord that matched but could not attack keeps the key from falling back to its profiles without chord
+TEST(KeyBindingsTest, MatchedChordHidesUnchordedProfiles)
+{
+    std::vector<BindingProfile> profiles(2);
+    profiles[0].rightHandKey = 45;
+    profiles[0].chordKeys = { 42, -1, -1, -1 };
+    profiles[1].bothHandsKey = 45;
+    KeyBindingTable bindings;
+    ASSERT_TRUE(bindings.Build(profiles));
+
+    auto state = DualWielding();
+    AttackStateMachine stateMachine;
+    stateMachine.UpdateKeyState(Press(42, true), bindings);
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 0.0, state), kHandRight);
+
+    state.isRightHandEquiped = false;
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 1.0, state), kHandNone);
+
+    stateMachine.UpdateKeyState(Press(42, false), bindings);
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 2.0, state), kHandBoth);
+}
+
+TEST(KeyBindingsTest, TapStreakSelectsTapProfile)
+{
+    std::vector<BindingProfile> profiles(3);
+    profiles[0].rightHandKey = 45;
+    profiles[0].taps = 1;
+    profiles[1].leftHandKey = 45;
+    profiles[2].bothHandsKey = 46;
+    KeyBindingTable bindings;
+    ASSERT_TRUE(bindings.Build(profiles));
+    const auto state = DualWielding();
+    AttackConfig config;
+    config.sequenceWindow = 0.3f;
+
+    AttackStateMachine stateMachine;
+    auto tick = [&](double now) {
+        ActionList actions;
+        stateMachine.Tick(now, state, bindings, config, actions);
+        return PowerAttackHand(actions);
+    };
+
+    // The first press waits for the sequence window before the single press profile attacks
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 0.0, state, config), kHandNone);
+    EXPECT_EQ(tick(0.1), kHandNone);
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 0.2, state, config), kHandRight);
+    // Only the double tap attacked
+    EXPECT_EQ(tick(0.6), kHandNone);
+    EXPECT_FALSE(stateMachine.HasPendingRepeats());
+
+    // The double tap consumed the streak, the next press starts a new one
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 0.7, state, config), kHandNone);
+    EXPECT_EQ(tick(1.05), kHandLeft);
+    // Too slow for a sequence
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 1.5, state, config), kHandNone);
+    EXPECT_EQ(tick(1.85), kHandLeft);
+
+    // Another power attack key breaks the streak, the waiting press attacks before it
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 2.0, state, config), kHandNone);
+    ActionList broken;
+    stateMachine.UpdateKeyState(Press(46, true), bindings);
+    stateMachine.Process(Press(46, true), 2.1, state, bindings, config, broken);
+    std::vector<std::uint8_t> hands;
+    for (const auto& action : broken) {
+        if (action.type == AttackType::kPower) hands.push_back(action.hand);
+    }
+    EXPECT_EQ(hands, (std::vector<std::uint8_t>{ kHandLeft, kHandBoth }));
+    stateMachine.UpdateKeyState(Press(46, false), bindings);
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 2.2, state, config), kHandNone);
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 2.3, state, config), kHandRight);
+}
+
+TEST(KeyBindingsTest, HoldProfileAttacksOnceHeldLongEnough)
+{
+    std::vector<BindingProfile> profiles(1);
+    profiles[0].rightHandKey = 45;
+    profiles[0].holdTime = 0.4f;
+    KeyBindingTable bindings;
+    ASSERT_TRUE(bindings.Build(profiles));
+    const auto state = DualWielding();
+    AttackConfig config;
+
+    AttackStateMachine stateMachine;
+    ActionList pressed;
+    stateMachine.UpdateKeyState(Press(45, true), bindings);
+    stateMachine.Process(Press(45, true), 0.0, state, bindings, config, pressed);
+    EXPECT_TRUE(pressed.empty());
+    EXPECT_TRUE(stateMachine.HasPendingRepeats());
+
+    ActionList early;
+    stateMachine.Tick(0.3, state, bindings, config, early);
+    EXPECT_TRUE(early.empty());
+
+    ActionList held;
+    stateMachine.Tick(0.45, state, bindings, config, held);
+    EXPECT_EQ(PowerAttackHand(held), kHandRight);
+    EXPECT_FALSE(stateMachine.HasPendingRepeats());
+
+    // Released before the hold time, nothing happens
+    ActionList released;
+    stateMachine.UpdateKeyState(Press(45, false), bindings);
+    stateMachine.UpdateKeyState(Press(45, true), bindings);
+    stateMachine.Process(Press(45, true), 1.0, state, bindings, config, released);
+    stateMachine.UpdateKeyState(Press(45, false), bindings);
+    EXPECT_FALSE(stateMachine.HasPendingRepeats());
+    stateMachine.Tick(1.5, state, bindings, config, released);
+    EXPECT_TRUE(released.empty());
+}
+
+// A press and a hold profile on the same key: the hold wins when the key stays down, the press otherwise
+TEST(KeyBindingsTest, HoldProfileFallsBackToPressProfile)
+{
+    std::vector<BindingProfile> profiles(2);
+    profiles[0].rightHandKey = 45;
+    profiles[0].holdTime = 0.4f;
+    profiles[1].leftHandKey = 45;
+    KeyBindingTable bindings;
+    ASSERT_TRUE(bindings.Build(profiles));
+    const auto state = DualWielding();
+    AttackConfig config;
+
+    AttackStateMachine stateMachine;
+    auto release = [&](double now) {
+        ActionList actions;
+        stateMachine.UpdateKeyState(Press(45, false), bindings);
+        stateMachine.Process(Press(45, false), now, state, bindings, config, actions);
+        return PowerAttackHand(actions);
+    };
+    auto tick = [&](double now) {
+        ActionList actions;
+        stateMachine.Tick(now, state, bindings, config, actions);
+        return PowerAttackHand(actions);
+    };
+
+    // Quick press and release
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 0.0, state, config), kHandNone);
+    EXPECT_EQ(tick(0.1), kHandLeft);
+    EXPECT_FALSE(stateMachine.HasPendingRepeats());
+
+    // Released key processed before the next tick
+    ActionList pressed;
+    stateMachine.UpdateKeyState(Press(45, true), bindings);
+    stateMachine.Process(Press(45, true), 1.0, state, bindings, config, pressed);
+    EXPECT_TRUE(pressed.empty());
+    EXPECT_EQ(release(1.1), kHandLeft);
+    EXPECT_EQ(tick(1.2), kHandNone);
+
+    // Held long enough, the press profile does not attack as well
+    stateMachine.UpdateKeyState(Press(45, true), bindings);
+    stateMachine.Process(Press(45, true), 2.0, state, bindings, config, pressed);
+    EXPECT_TRUE(pressed.empty());
+    EXPECT_EQ(tick(2.45), kHandRight);
+    EXPECT_EQ(release(2.6), kHandNone);
+    EXPECT_EQ(tick(3.0), kHandNone);
+    EXPECT_FALSE(stateMachine.HasPendingRepeats());
+}
+
+// The profiles whose chord keys do not fit the held chord mask are skipped, the others still work
+TEST(KeyBindingsTest, ChordKeyOverflowFailsBuild)
+{
+    std::vector<BindingProfile> profiles(kMaxChordMaskKeys + 1);
+    for (std::size_t i = 0; i < profiles.size(); ++i) {
+        profiles[i].rightHandKey = 45;
+        profiles[i].chordKeys[0] = static_cast<int>(100 + i);
+    }
+    KeyBindingTable bindings;
+    EXPECT_FALSE(bindings.Build(profiles));
+    EXPECT_TRUE(bindings.Get(100 + kMaxChordMaskKeys - 1).IsChordKey());
+    EXPECT_FALSE(bindings.Get(100 + kMaxChordMaskKeys).IsChordKey());
+    EXPECT_EQ(bindings.GetCandidates(bindings.Get(45)).size(), kMaxChordMaskKeys);
+
+    const auto state = DualWielding();
+    AttackStateMachine stateMachine;
+    stateMachine.UpdateKeyState(Press(100, true), bindings);
+    EXPECT_EQ(PressAndRelease(stateMachine, bindings, 45, 0.0, state), kHandRight);
+
+    profiles.pop_back();
+    EXPECT_TRUE(bindings.Build(profiles));
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "SettingsSchema.h"
+
+using namespace SettingsSchema;
+
+namespace
+{
+    using Section = std::map<std::string, std::string>;
+
+    // Loads a section the way Settings.cpp does, with the names of the invalid keys collected instead of logged
+    template <class Values, std::size_t Count>
+    std::vector<std::string> Load(const std::array<SettingSpec<Values>, Count>& schema, const Section& section, Values& values)
+    {
+        std::vector<std::string> invalid;
+        LoadSchema(
+            schema, values,
+            [&](const SettingSpec<Values>& spec) {
+                const auto key = section.find(spec.name);
+                return key != section.end() ? key->second.c_str() : nullptr;
+            },
+            [&](const SettingSpec<Values>& spec, std::string_view) { invalid.emplace_back(spec.name); });
+        return invalid;
+    }
+}
+
+TEST(SettingsSchemaTest, MissingKeysTakeTheirDefault)
+{
+    SettingsValues values;
+    values.attackConfig.consecutiveAttacksDelay = 99.0f;
+    EXPECT_TRUE(Load(kSettingsSchema, {}, values).empty());
+    EXPECT_EQ(values.legacyProfiles[0].rightHandKey, 45);
+    EXPECT_EQ(values.legacyProfiles[1].rightHandKey, 281);
+    EXPECT_FLOAT_EQ(values.attackConfig.consecutiveAttacksDelay, 0.5f);
+    EXPECT_EQ(values.logLevel, 2);
+    EXPECT_EQ(values.flushLevel, 3);
+    EXPECT_EQ(values.logQueueSize, 8192u);
+}
+
+TEST(SettingsSchemaTest, InvalidValuesAreReportedAndDefaulted)
+{
+    const Section section{
+        { "iRightHandKey", "4x" },              // Trailing garbage
+        { "iLeftHandKey", "282" },              // Past the last keycode
+        { "fConsecutiveAttacksDelay", " 0.25 " },
+        { "bUsingMCO", "true" },
+        { "bEnableStats", "yes" },
+        { "iStaminaCost1H", "5000" },
+        { "sLogLevel", "warn" },
+        { "sFlushLevel", "loud" },
+    };
+    SettingsValues values;
+    const auto invalid = Load(kSettingsSchema, section, values);
+    EXPECT_EQ(invalid, (std::vector<std::string>{ "iRightHandKey", "iLeftHandKey", "iStaminaCost1H", "bEnableStats", "sFlushLevel" }));
+    EXPECT_EQ(values.legacyProfiles[0].rightHandKey, 45);
+    EXPECT_EQ(values.legacyProfiles[0].leftHandKey, -1);
+    EXPECT_FLOAT_EQ(values.attackConfig.consecutiveAttacksDelay, 0.25f);
+    EXPECT_TRUE(values.attackConfig.usingMCO);
+    EXPECT_FALSE(values.enableStats);
+    EXPECT_EQ(values.attackConfig.staminaCost1H, 15);
+    EXPECT_EQ(values.logLevel, 3);
+    EXPECT_EQ(values.flushLevel, 3);
+}
+
+TEST(SettingsSchemaTest, LogLevelNames)
+{
+    EXPECT_EQ(ParseLogLevel("trace"), 0);
+    EXPECT_EQ(ParseLogLevel("warning"), 3);
+    EXPECT_EQ(ParseLogLevel("err"), 4);
+    EXPECT_EQ(ParseLogLevel("off"), 6);
+    EXPECT_FALSE(ParseLogLevel("Info"));
+}
+
+TEST(SettingsSchemaTest, ProfileKeys)
+{
+    const Section section{
+        { "iDualWieldKey", "45" },
+        { "sChordKeys", "42, 29" },
+        { "iTaps", "1" },
+        { "fHoldTime", "0.4" },
+        { "sDirections", "Neutral:Forward, left:Back" },
+    };
+    BindingProfile profile;
+    EXPECT_TRUE(Load(kProfileSchema, section, profile).empty());
+    EXPECT_EQ(profile.rightHandKey, -1);
+    EXPECT_EQ(profile.bothHandsKey, 45);
+    EXPECT_EQ(profile.chordKeys, (std::array<int, kMaxChordKeys>{ 42, 29, -1, -1 }));
+    EXPECT_EQ(profile.taps, 1u);
+    EXPECT_FLOAT_EQ(profile.holdTime, 0.4f);
+    EXPECT_EQ(profile.directions[std::to_underlying(MoveDirection::kNeutral)], MoveDirection::kForward);
+    EXPECT_EQ(profile.directions[std::to_underlying(MoveDirection::kLeft)], MoveDirection::kBack);
+    EXPECT_EQ(profile.directions[std::to_underlying(MoveDirection::kRight)], MoveDirection::kNeutral);
+}
+
+// Profile keys go through the same checks as [Settings], instead of whatever the INI library makes of them
+TEST(SettingsSchemaTest, InvalidProfileKeys)
+{
+    const Section section{
+        { "iRightHandKey", "X" },
+        { "sChordKeys", "42, 29, 56, 54, 157" },  // More than kMaxChordKeys
+        { "iTaps", "-1" },
+        { "fHoldTime", "0.4s" },
+        { "sDirections", "Neutral:Up" },
+    };
+    BindingProfile profile;
+    const auto invalid = Load(kProfileSchema, section, profile);
+    EXPECT_EQ(invalid, (std::vector<std::string>{ "iRightHandKey", "sChordKeys", "iTaps", "fHoldTime", "sDirections" }));
+    EXPECT_EQ(profile.rightHandKey, -1);
+    EXPECT_EQ(profile.chordKeys, (std::array<int, kMaxChordKeys>{ -1, -1, -1, -1 }));
+    EXPECT_EQ(profile.taps, 0u);
+    EXPECT_FLOAT_EQ(profile.holdTime, 0.0f);
+    EXPECT_EQ(profile.directions, DirectionTable{});
+
+    EXPECT_FALSE(ParseChordKeys("42,282"));
+    EXPECT_FALSE(ParseDirections("Forward"));
+    EXPECT_TRUE(ParseDirections(" , "));
+}
+
+TEST(SettingsSchemaTest, WeaponKeys)
+{
+    WeaponProfile profile;
+    EXPECT_TRUE(Load(kWeaponSchema, { { "iStaminaCost", "40" }, { "fConsecutiveAttacksDelay", "0.7" } }, profile).empty());
+    EXPECT_EQ(profile.staminaCost, 40);
+    EXPECT_FLOAT_EQ(profile.repeatDelay, 0.7f);
+    EXPECT_EQ(profile.lightAttackFirst, -1);
+
+    WeaponProfile invalid;
+    EXPECT_EQ(Load(kWeaponSchema, { { "iStaminaCost", "-5" }, { "iLightAttackFirst", "2" } }, invalid), (std::vector<std::string>{ "iStaminaCost", "iLightAttackFirst" }));
+    EXPECT_EQ(invalid.staminaCost, -1);
+    EXPECT_EQ(invalid.lightAttackFirst, -1);
+}
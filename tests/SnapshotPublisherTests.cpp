@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+#include "SnapshotPublisher.h"
+
+namespace
+{
+    // Every field is derived from the version, a reader seeing a half written value would find them disagreeing
+    struct Versioned
+    {
+        std::uint32_t version = 0;
+        std::array<std::uint32_t, 64> keys{};
+
+        explicit Versioned(std::uint32_t v) : version(v) { keys.fill(v * 2654435761u); }
+
+        bool IsConsistent() const
+        {
+            for (const auto key : keys) {
+                if (key != version * 2654435761u) return false;
+            }
+            return true;
+        }
+
+        bool operator==(const Versioned&) const = default;
+    };
+}
+
+// Readers spin on Get like the input sink while writers keep replacing the value, as remaps and reloads do
+TEST(SnapshotPublisherTest, ReadersNeverSeeTornOrFreedValues)
+{
+    constexpr std::uint32_t kWriters = 2;
+    constexpr std::uint32_t kPublishesPerWriter = 5000;
+    constexpr std::size_t kReaders = 4;
+
+    SnapshotPublisher<Versioned> publisher;
+    publisher.Publish(std::make_unique<const Versioned>(0));
+
+    std::atomic<bool> writing = true;
+    std::atomic<std::uint32_t> failures = 0;
+    std::vector<std::jthread> readers;
+    for (std::size_t reader = 0; reader < kReaders; ++reader) {
+        readers.emplace_back([&] {
+            std::vector<const Versioned*> held;
+            do {
+                const auto value = publisher.Get();
+                if (!value || !value->IsConsistent()) failures.fetch_add(1, std::memory_order_relaxed);
+                // A reader may keep using an old value for a while, it has to stay intact
+                held.push_back(value);
+                if (held.size() == 256) {
+                    for (const auto old : held) {
+                        if (!old->IsConsistent()) failures.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    held.clear();
+                }
+            } while (writing.load(std::memory_order_acquire));
+        });
+    }
+
+    {
+        std::vector<std::jthread> writers;
+        for (std::uint32_t writer = 0; writer < kWriters; ++writer) {
+            writers.emplace_back([&, writer] {
+                for (std::uint32_t i = 1; i <= kPublishesPerWriter; ++i) {
+                    publisher.Publish(std::make_unique<const Versioned>(writer * kPublishesPerWriter + i));
+                }
+            });
+        }
+    }
+    writing.store(false, std::memory_order_release);
+    readers.clear();
+
+    EXPECT_EQ(failures.load(), 0u);
+    EXPECT_EQ(publisher.GetPublishCount(), kWriters * kPublishesPerWriter + 1);
+}
+
+TEST(SnapshotPublisherTest, EqualValuesAreNotRepublished)
+{
+    SnapshotPublisher<Versioned> publisher;
+    EXPECT_EQ(publisher.Get(), nullptr);
+    EXPECT_TRUE(publisher.PublishIfChanged(std::make_unique<const Versioned>(1)));
+    const auto first = publisher.Get();
+    EXPECT_FALSE(publisher.PublishIfChanged(std::make_unique<const Versioned>(1)));
+    EXPECT_EQ(publisher.Get(), first);
+    EXPECT_TRUE(publisher.PublishIfChanged(std::make_unique<const Versioned>(2)));
+    EXPECT_EQ(publisher.Get()->version, 2u);
+    // The replaced value stays readable
+    EXPECT_EQ(first->version, 1u);
+    EXPECT_EQ(publisher.GetPublishCount(), 2u);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal runner with the shape of a Google Benchmark suite, so the plugin's tools need no extra dependency:
+// each benchmark loops over `for ([[maybe_unused]] auto _ : state)` and the runner grows the iteration count until a run is long enough
+namespace Bench
+{
+    template <class T>
+    inline void DoNotOptimize(T const& value)
+    {
+#if defined(_MSC_VER)
+        static volatile const void* sink;
+        sink = &value;
+#else
+        asm volatile("" : : "r,m"(value) : "memory");
+#endif
+    }
+
+    class State
+    {
+        public:
+            explicit State(std::uint64_t iterations) : iterations(iterations) {}
+
+            struct Iterator
+            {
+                std::uint64_t remaining;
+                bool operator!=(const Iterator&) const { return remaining != 0; }
+                void operator++() { --remaining; }
+                int operator*() const { return 0; }
+            };
+
+            Iterator begin()
+            {
+                start = std::chrono::steady_clock::now();
+                return { iterations };
+            }
+
+            Iterator end()
+            {
+                return { 0 };
+            }
+
+            // Items handled per iteration, reported as ns per item
+            void SetItemsProcessed(std::uint64_t items) { itemsProcessed = items; }
+            void SetLabel(std::string text) { label = std::move(text); }
+
+            std::uint64_t iterations;
+            std::uint64_t itemsProcessed = 0;
+            std::chrono::steady_clock::time_point start;
+            std::string label;
+    };
+
+    struct Benchmark
+    {
+        std::string name;
+        std::function<void(State&)> function;
+    };
+
+    inline std::vector<Benchmark>& Registry()
+    {
+        static std::vector<Benchmark> benchmarks;
+        return benchmarks;
+    }
+
+    inline int Register(std::string name, std::function<void(State&)> function)
+    {
+        Registry().push_back({ std::move(name), std::move(function) });
+        return 0;
+    }
+
+    // Runs the benchmarks whose name contains filter, an empty filter runs all of them
+    inline void RunAll(const std::string& filter)
+    {
+        std::printf("%-44s %14s %14s %12s\n", "Benchmark", "ns/iteration", "ns/item", "Iterations");
+        for (const auto& benchmark : Registry()) {
+            if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) continue;
+
+            std::uint64_t iterations = 1;
+            for (;;) {
+                State state(iterations);
+                benchmark.function(state);
+                const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - state.start).count();
+                if (elapsed < 2e8 && iterations < (1ull << 40)) {
+                    iterations *= elapsed < 2e7 ? 10 : 2;
+                    continue;
+                }
+                const double perIteration = elapsed / static_cast<double>(iterations);
+                const double perItem = state.itemsProcessed ? elapsed / static_cast<double>(state.itemsProcessed) : perIteration;
+                std::printf("%-44s %14.1f %14.2f %12llu %s\n", benchmark.name.c_str(), perIteration, perItem,
+                            static_cast<unsigned long long>(iterations), state.label.c_str());
+                break;
+            }
+        }
+    }
+}
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+#define BENCHMARK(function) static const int BENCH_CONCAT(registered_, __LINE__) = Bench::Register(#function, function)
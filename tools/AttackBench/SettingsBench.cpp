@@ -0,0 +1,89 @@
+// Cold start cost of the settings: every key parsed and checked against the schema, then the binding table built.
+// The INI is already in memory, so this leaves out the file read done by SimpleIni
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "SettingsSchema.h"
+
+using namespace SettingsSchema;
+
+namespace
+{
+    using Section = std::map<std::string, std::string, std::less<>>;
+
+    // A complete [Settings] section plus the given number of profiles and weapon overrides
+    struct IniContents
+    {
+        Section settings;
+        std::vector<Section> profiles;
+        std::vector<Section> weapons;
+    };
+
+    IniContents MakeIni(int profileCount, int weaponCount)
+    {
+        IniContents ini;
+        for (const auto& spec : kSettingsSchema) ini.settings.emplace(spec.name, spec.defaultValue);
+        for (int i = 0; i < profileCount; ++i) {
+            ini.profiles.push_back({
+                { "iRightHandKey", std::to_string(2 + i) },
+                { "sChordKeys", i % 2 ? "42" : "42, 29" },
+                { "iTaps", i % 3 == 1 ? "1" : "0" },
+                { "fHoldTime", i % 3 == 2 ? "0.4" : "0.0" },
+                { "sDirections", "Neutral:Forward, Left:Left, Right:Right" },
+            });
+        }
+        for (int i = 0; i < weaponCount; ++i) {
+            ini.weapons.push_back({ { "iStaminaCost", "40" }, { "fConsecutiveAttacksDelay", "0.7" }, { "iLightAttackFirst", "1" } });
+        }
+        return ini;
+    }
+
+    template <class Values, std::size_t Count>
+    void Load(const std::array<SettingSpec<Values>, Count>& schema, const Section& section, Values& values)
+    {
+        LoadSchema(
+            schema, values,
+            [&](const SettingSpec<Values>& spec) {
+                const auto key = section.find(std::string_view(spec.name));
+                return key != section.end() ? key->second.c_str() : nullptr;
+            },
+            [](const SettingSpec<Values>&, std::string_view) {});
+    }
+
+    void ParseSettings(Bench::State& state, const IniContents& ini)
+    {
+        for ([[maybe_unused]] auto _ : state) {
+            SettingsValues values;
+            Load(kSettingsSchema, ini.settings, values);
+
+            std::vector<BindingProfile> profiles(values.legacyProfiles.begin(), values.legacyProfiles.end());
+            for (const auto& section : ini.profiles) Load(kProfileSchema, section, profiles.emplace_back());
+
+            std::vector<WeaponProfile> weapons;
+            for (const auto& section : ini.weapons) Load(kWeaponSchema, section, weapons.emplace_back());
+
+            KeyBindingTable bindings;
+            Bench::DoNotOptimize(bindings.Build(profiles));
+            Bench::DoNotOptimize(weapons);
+        }
+        const auto keys = kSettingsSchema.size() + ini.profiles.size() * kProfileSchema.size() + ini.weapons.size() * kWeaponSchema.size();
+        state.SetItemsProcessed(state.iterations * keys);
+        state.SetLabel(std::to_string(keys) + " keys, " + std::to_string(ini.profiles.size()) + " profiles");
+    }
+
+    void BM_ParseDefaultSettings(Bench::State& state)
+    {
+        static const auto ini = MakeIni(0, 0);
+        ParseSettings(state, ini);
+    }
+    BENCHMARK(BM_ParseDefaultSettings);
+
+    void BM_ParseSettings20Profiles(Bench::State& state)
+    {
+        static const auto ini = MakeIni(20, 20);
+        ParseSettings(state, ini);
+    }
+    BENCHMARK(BM_ParseSettings20Profiles);
+}
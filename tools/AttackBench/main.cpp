@@ -0,0 +1,337 @@
+// Cost of the attack decisions per input event, on synthetic streams shaped like each device's input
+#include <array>
+#include <random>
+#include <vector>
+
+#include "AttackStateMachine.h"
+#include "Bench.h"
+
+namespace
+{
+    constexpr double kFrame = 1.0 / 60.0;
+
+    struct StreamEvent
+    {
+        ButtonInput input;
+        double time = 0.0;
+    };
+
+    ButtonInput MakeInput(InputDevice device, std::uint32_t keycode, float value, float heldDownSecs, std::uint8_t attackHands = kHandNone)
+    {
+        ButtonInput input;
+        input.device = device;
+        input.keycode = keycode;
+        input.value = value;
+        input.heldDownSecs = heldDownSecs;
+        input.attackHands = attackHands;
+        return input;
+    }
+
+    // Down, held events every frame for a while, then up
+    void AppendPress(std::vector<StreamEvent>& stream, double& time, InputDevice device, std::uint32_t keycode, int heldFrames, std::uint8_t attackHands = kHandNone)
+    {
+        stream.push_back({ MakeInput(device, keycode, 1.0f, 0.0f, attackHands), time });
+        for (int frame = 1; frame <= heldFrames; ++frame) {
+            time += kFrame;
+            stream.push_back({ MakeInput(device, keycode, 1.0f, static_cast<float>(frame * kFrame), attackHands), time });
+        }
+        time += kFrame;
+        stream.push_back({ MakeInput(device, keycode, 0.0f, static_cast<float>((heldFrames + 1) * kFrame), attackHands), time });
+    }
+
+    // WASD and letter keys around the power attack key and its chord, typing speed presses
+    std::vector<StreamEvent> KeyboardStream()
+    {
+        std::mt19937 random(1);
+        std::vector<StreamEvent> stream;
+        double time = 0.0;
+        for (int i = 0; i < 2000; ++i) {
+            switch (random() % 6) {
+                case 0: AppendPress(stream, time, InputDevice::kKeyboard, 45, 2); break;
+                case 1:
+                    stream.push_back({ MakeInput(InputDevice::kKeyboard, 42, 1.0f, 0.0f), time });
+                    AppendPress(stream, time, InputDevice::kKeyboard, 45, 1);
+                    stream.push_back({ MakeInput(InputDevice::kKeyboard, 42, 0.0f, 0.2f), time });
+                    break;
+                default: AppendPress(stream, time, InputDevice::kKeyboard, 16 + random() % 20, static_cast<int>(random() % 10)); break;
+            }
+        }
+        return stream;
+    }
+
+    // Attack buttons held for light attack chains, with the power attack on a side button
+    std::vector<StreamEvent> MouseStream()
+    {
+        std::mt19937 random(2);
+        std::vector<StreamEvent> stream;
+        double time = 0.0;
+        for (int i = 0; i < 2000; ++i) {
+            switch (random() % 4) {
+                case 0: AppendPress(stream, time, InputDevice::kMouse, 259, 2); break;
+                case 1: AppendPress(stream, time, InputDevice::kMouse, 256, 40, kHandRight); break;
+                case 2: AppendPress(stream, time, InputDevice::kMouse, 257, 40, kHandLeft); break;
+                default: AppendPress(stream, time, InputDevice::kMouse, 258, 5); break;
+            }
+        }
+        return stream;
+    }
+
+    // Triggers mapped to the attacks, long holds that flood held events, power attack on a shoulder button
+    std::vector<StreamEvent> GamepadStream()
+    {
+        std::mt19937 random(3);
+        std::vector<StreamEvent> stream;
+        double time = 0.0;
+        for (int i = 0; i < 2000; ++i) {
+            switch (random() % 4) {
+                case 0: AppendPress(stream, time, InputDevice::kGamepad, 275, 3); break;
+                case 1: AppendPress(stream, time, InputDevice::kGamepad, 281, 90, kHandRight); break;
+                case 2: AppendPress(stream, time, InputDevice::kGamepad, 280, 90, kHandLeft); break;
+                default: AppendPress(stream, time, InputDevice::kGamepad, 276 + random() % 4, 4); break;
+            }
+        }
+        return stream;
+    }
+
+    std::vector<BindingProfile> DefaultProfiles()
+    {
+        std::vector<BindingProfile> profiles(4);
+        profiles[0].rightHandKey = 45;
+        profiles[1].bothHandsKey = 45;
+        profiles[1].chordKeys[0] = 42;
+        profiles[2].rightHandKey = 259;
+        profiles[3].rightHandKey = 275;
+        return profiles;
+    }
+
+    // The default profiles plus more on keys the streams do not press, with the chord, tap and hold conditions mixed in
+    std::vector<BindingProfile> ManyProfiles(std::size_t count)
+    {
+        auto profiles = DefaultProfiles();
+        for (std::size_t i = 0; i < count; ++i) {
+            BindingProfile profile;
+            profile.rightHandKey = static_cast<int>(60 + i % 140);
+            if (i < kMaxChordMaskKeys - 4) profile.chordKeys[0] = static_cast<int>(200 + i);
+            profile.taps = i % 3 == 1 ? 1 : 0;
+            profile.holdTime = i % 3 == 2 ? 0.4f : 0.0f;
+            profiles.push_back(profile);
+        }
+        return profiles;
+    }
+
+    PlayerCombatSnapshot AttackingState()
+    {
+        PlayerCombatSnapshot state;
+        state.canAttack = true;
+        state.isAttacking = true;
+        state.isRightHandEquiped = true;
+        state.isLeftHandEquiped = true;
+        return state;
+    }
+
+    // One iteration replays the whole stream, with a Tick per frame like the game's update hook
+    void RunStream(Bench::State& state, const std::vector<StreamEvent>& stream, const std::vector<BindingProfile>& profiles = DefaultProfiles())
+    {
+        KeyBindingTable bindings;
+        bindings.Build(profiles);
+        AttackConfig config;
+        config.holdConsecutivePA = true;
+        config.holdConsecutiveLA = true;
+        const auto snapshot = AttackingState();
+
+        for ([[maybe_unused]] auto _ : state) {
+            AttackStateMachine stateMachine;
+            double lastTick = 0.0;
+            for (const auto& event : stream) {
+                ActionList actions;
+                stateMachine.UpdateKeyState(event.input, bindings);
+                Bench::DoNotOptimize(stateMachine.Process(event.input, event.time, snapshot, bindings, config, actions));
+                if (event.time - lastTick >= kFrame) {
+                    stateMachine.Tick(event.time, snapshot, bindings, config, actions);
+                    lastTick = event.time;
+                }
+                Bench::DoNotOptimize(actions);
+            }
+        }
+        state.SetItemsProcessed(state.iterations * stream.size());
+        state.SetLabel(std::to_string(stream.size()) + " events, " + std::to_string(profiles.size()) + " profiles");
+    }
+
+    // The primary, Alt1 and Alt2 key sets of the old INI, each one with its combo key
+    struct LegacySlot
+    {
+        int rightHandKey = -1;
+        int leftHandKey = -1;
+        int bothHandsKey = -1;
+        int comboKey = -1;
+    };
+
+    using LegacySlots = std::array<LegacySlot, 3>;
+
+    // DefaultProfiles as far as three key sets allow: the device's own power attack key takes the Alt2 set
+    LegacySlots DefaultSlots(int devicePowerKey)
+    {
+        return { { { .rightHandKey = 45 }, { .bothHandsKey = 45, .comboKey = 42 }, { .rightHandKey = devicePowerKey } } };
+    }
+
+    // Before: the work ProcessEvent did per button event before the binding table, with the keycode compared against every
+    // key of the three sets and the if/else chain deciding the hand, the held power attack repeats timed from heldDownSecs.
+    // The light attack repeats are left out, so it does less work than the state machine on the held events
+    class LegacyChain
+    {
+        public:
+            explicit LegacyChain(const LegacySlots& slots) : slots(slots) {}
+
+            void Process(const ButtonInput& input, const PlayerCombatSnapshot& state, const AttackConfig& config, ActionList& out)
+            {
+                const int keycode = static_cast<int>(input.keycode);
+                for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+                    if (slots[slot].comboKey > 0 && keycode == slots[slot].comboKey) comboActive[slot] = input.IsPressed();
+                }
+
+                bool isPowerAttackKey = false;
+                for (const auto& slot : slots) {
+                    isPowerAttackKey |= keycode == slot.rightHandKey || keycode == slot.leftHandKey || keycode == slot.bothHandsKey;
+                }
+                if ((input.IsDown() || input.IsUp()) && isPowerAttackKey) {
+                    powerAttackWaiting = false;
+                    powerAttackHeldTime = 0.0f;
+                }
+
+                const bool held = input.IsHeld() && config.holdConsecutivePA && state.isAttacking;
+                if (!isPowerAttackKey || !(input.IsDown() || held)) return;
+                if (held) {
+                    if (!powerAttackWaiting) powerAttackHeldTime = input.heldDownSecs;
+                    powerAttackWaiting = input.heldDownSecs - powerAttackHeldTime <= config.consecutiveAttacksDelay;
+                    if (powerAttackWaiting || state.isBlocking) return;
+                }
+                if (const auto hand = Decide(keycode, state); hand != kHandNone) out.Push(hand, AttackType::kPower);
+            }
+
+        private:
+            std::uint8_t Decide(int keycode, const PlayerCombatSnapshot& state) const
+            {
+                const bool isLeftHandAllowed = state.isLeftHandEquiped && (!state.isLeftHandUnarmed || (state.isLeftHandUnarmed && state.isRightHandUnarmed));
+                bool isKeyWithCombo = false;
+
+                // Combos take priority
+                for (std::size_t slot = 0; slot < slots.size(); ++slot) {
+                    const auto& keys = slots[slot];
+                    const bool isUsingCombo = comboActive[slot] && !(comboActive[(slot + 1) % 3] || comboActive[(slot + 2) % 3]);
+                    if (!isUsingCombo || keys.comboKey <= 0) continue;
+                    if (keycode == keys.rightHandKey && state.isRightHandEquiped) {
+                        return kHandRight;
+                    } else if (keycode == keys.leftHandKey && isLeftHandAllowed) {
+                        return kHandLeft;
+                    } else if (keycode == keys.bothHandsKey) {
+                        return kHandBoth;
+                    }
+                    if (keycode == keys.rightHandKey || keycode == keys.leftHandKey || keycode == keys.bothHandsKey) isKeyWithCombo = true;
+                }
+
+                const auto& [primary, alt1, alt2] = slots;
+                if (((keycode == primary.rightHandKey && primary.comboKey <= 0) || (keycode == alt1.rightHandKey && alt1.comboKey <= 0) ||
+                     (keycode == alt2.rightHandKey && alt2.comboKey <= 0)) && state.isRightHandEquiped && !isKeyWithCombo) {
+                    return kHandRight;
+                } else if (((keycode == primary.leftHandKey && primary.comboKey <= 0) || (keycode == alt1.leftHandKey && alt1.comboKey <= 0) ||
+                            (keycode == alt2.leftHandKey && alt2.comboKey <= 0)) && isLeftHandAllowed && !isKeyWithCombo) {
+                    return kHandLeft;
+                } else if (((keycode == primary.bothHandsKey && primary.comboKey <= 0) || (keycode == alt1.bothHandsKey && alt1.comboKey <= 0) ||
+                            (keycode == alt2.bothHandsKey && alt2.comboKey <= 0)) && !isKeyWithCombo) {
+                    return kHandBoth;
+                }
+                return kHandNone;
+            }
+
+            LegacySlots slots;
+            std::array<bool, 3> comboActive{};
+            bool powerAttackWaiting = false;
+            float powerAttackHeldTime = 0.0f;
+    };
+
+    // Same streams and labels as RunStream, without the frame Tick the old handler did not have
+    void RunLegacyChain(Bench::State& state, const std::vector<StreamEvent>& stream, const LegacySlots& slots)
+    {
+        AttackConfig config;
+        config.holdConsecutivePA = true;
+        config.holdConsecutiveLA = true;
+        const auto snapshot = AttackingState();
+
+        for ([[maybe_unused]] auto _ : state) {
+            LegacyChain chain(slots);
+            for (const auto& event : stream) {
+                ActionList actions;
+                chain.Process(event.input, snapshot, config, actions);
+                Bench::DoNotOptimize(actions);
+            }
+        }
+        state.SetItemsProcessed(state.iterations * stream.size());
+        state.SetLabel(std::to_string(stream.size()) + " events, 3 key sets");
+    }
+
+    void BM_KeyboardStream(Bench::State& state)
+    {
+        static const auto stream = KeyboardStream();
+        RunStream(state, stream);
+    }
+    BENCHMARK(BM_KeyboardStream);
+
+    void BM_MouseStream(Bench::State& state)
+    {
+        static const auto stream = MouseStream();
+        RunStream(state, stream);
+    }
+    BENCHMARK(BM_MouseStream);
+
+    void BM_GamepadStream(Bench::State& state)
+    {
+        static const auto stream = GamepadStream();
+        RunStream(state, stream);
+    }
+    BENCHMARK(BM_GamepadStream);
+
+    // Same stream as BM_KeyboardStream, the time per event should not move with the profile count
+    void BM_KeyboardStream64Profiles(Bench::State& state)
+    {
+        static const auto stream = KeyboardStream();
+        static const auto profiles = ManyProfiles(60);
+        RunStream(state, stream, profiles);
+    }
+    BENCHMARK(BM_KeyboardStream64Profiles);
+
+    void BM_KeyboardStream254Profiles(Bench::State& state)
+    {
+        static const auto stream = KeyboardStream();
+        static const auto profiles = ManyProfiles(250);
+        RunStream(state, stream, profiles);
+    }
+    BENCHMARK(BM_KeyboardStream254Profiles);
+
+    // The chain the table replaced, on the same streams: compare with BM_KeyboardStream, BM_MouseStream and BM_GamepadStream
+    void BM_LegacyChainKeyboard(Bench::State& state)
+    {
+        static const auto stream = KeyboardStream();
+        RunLegacyChain(state, stream, DefaultSlots(259));
+    }
+    BENCHMARK(BM_LegacyChainKeyboard);
+
+    void BM_LegacyChainMouse(Bench::State& state)
+    {
+        static const auto stream = MouseStream();
+        RunLegacyChain(state, stream, DefaultSlots(259));
+    }
+    BENCHMARK(BM_LegacyChainMouse);
+
+    void BM_LegacyChainGamepad(Bench::State& state)
+    {
+        static const auto stream = GamepadStream();
+        RunLegacyChain(state, stream, DefaultSlots(275));
+    }
+    BENCHMARK(BM_LegacyChainGamepad);
+}
+
+int main(int argc, char** argv)
+{
+    Bench::RunAll(argc > 1 ? argv[1] : "");
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Feeds a recording back through AttackStateMachine and reports every action with its timing,
+// flagging the inputs where the current decision logic differs from the recorded one.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include "InputRecording.h"
+
+namespace
+{
+    const char* HandName(std::uint8_t hand)
+    {
+        switch (hand) {
+            case kHandRight: return "right";
+            case kHandLeft: return "left";
+            case kHandBoth: return "both";
+            default: return "none";
+        }
+    }
+
+    const char* EdgeName(const ButtonInput& input)
+    {
+        if (input.IsDown()) return "down";
+        if (input.IsUp()) return "up";
+        if (input.IsHeld()) return "held";
+        return "-";
+    }
+
+    const char* WindowEventName(std::uint32_t event)
+    {
+        constexpr std::array names{ "swing", "light", "light end", "power", "power end", "stop" };
+        return event < names.size() ? names[event] : "?";
+    }
+
+    void PrintActions(const AttackAction* first, const AttackAction* last)
+    {
+        if (first == last) std::printf("nothing");
+        for (auto action = first; action != last; ++action) {
+            std::printf("%s%s %s", action == first ? "" : ", ", action->type == AttackType::kPower ? "PA" : "LA", HandName(action->hand));
+        }
+    }
+
+    bool SameActions(const ActionList& replayed, const InputRecord& record)
+    {
+        if (replayed.count != record.actionCount) return false;
+        for (std::uint8_t i = 0; i < replayed.count; ++i) {
+            const auto& action = replayed.actions[i];
+            const auto& recorded = record.actions[i];
+            if (action.hand != recorded.hand || action.type != recorded.type || action.directions != recorded.directions) return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <PowerAttackKey.rec> [--quiet]\n", argv[0]);
+        return 2;
+    }
+    const bool quiet = argc > 2 && std::string_view(argv[2]) == "--quiet";
+
+    std::ifstream file(argv[1], std::ios::binary);
+    RecordingHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != kRecordingMagic) {
+        std::fprintf(stderr, "%s is not an input recording\n", argv[1]);
+        return 1;
+    }
+    if (header.version != kRecordingVersion) {
+        std::fprintf(stderr, "Recording version %u is not supported, expected %u\n", header.version, kRecordingVersion);
+        return 1;
+    }
+
+    std::vector<BindingProfile> profiles(header.profileCount);
+    if (!file.read(reinterpret_cast<char*>(profiles.data()), profiles.size() * sizeof(BindingProfile))) {
+        std::fprintf(stderr, "%s is truncated\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<InputRecord> records;
+    for (InputRecord record; file.read(reinterpret_cast<char*>(&record), sizeof(record));) {
+        records.push_back(record);
+    }
+
+    KeyBindingTable bindings;
+    bindings.Build(profiles);
+    AttackStateMachine stateMachine;
+
+    std::size_t actionCount = 0;
+    std::size_t mismatches = 0;
+    std::size_t menuBlocked = 0;
+    std::size_t notReady = 0;
+    std::uint64_t recordedDecisionNs = 0;
+    std::uint32_t recordedDecisionMaxNs = 0;
+    std::chrono::nanoseconds replayTime{};
+
+    for (const auto& record : records) {
+        ActionList actions;
+        const auto start = std::chrono::steady_clock::now();
+        bool consumed = false;
+        if (record.flags & kRecordDispatch) {
+            // Decided earlier, only a rejected dispatch changes the state
+            if (record.flags & kRecordDispatchFailed) stateMachine.BufferPowerAttack(record.input.keycode, record.time, header.config);
+            actions.count = record.actionCount;
+            actions.actions = record.actions;
+        } else if (record.flags & kRecordWindow) {
+            stateMachine.OnAttackWindow(static_cast<AttackWindowEvent>(record.input.keycode), record.time, record.state, bindings, header.config, actions);
+        } else if (record.flags & kRecordRetry) {
+            stateMachine.RetryBuffered(record.state, bindings, header.config, actions);
+            stateMachine.ResolveBuffered(!(record.flags & kRecordDispatchFailed));
+        } else if (record.flags & kRecordTick) {
+            stateMachine.Tick(record.time, record.state, bindings, header.config, actions);
+        } else {
+            stateMachine.UpdateKeyState(record.input, bindings);
+            // Inputs that were not decided only update the key state, as in the game
+            const bool undecided = record.flags & (kRecordMenuBlocked | kRecordNotReady);
+            if (record.flags & kRecordMenuBlocked) ++menuBlocked;
+            if (record.flags & kRecordNotReady) ++notReady;
+            consumed = !undecided && stateMachine.Process(record.input, record.time, record.state, bindings, header.config, actions);
+        }
+        replayTime += std::chrono::steady_clock::now() - start;
+
+        if (!(record.flags & kRecordDispatch)) actionCount += actions.count;
+        recordedDecisionNs += record.decisionNs;
+        recordedDecisionMaxNs = std::max(recordedDecisionMaxNs, record.decisionNs);
+
+        const bool matches = SameActions(actions, record) && consumed == ((record.flags & kRecordConsumed) != 0);
+        if (!matches) ++mismatches;
+        if (quiet && matches) continue;
+        if (!matches || !actions.empty()) {
+            if (record.flags & kRecordDispatch) {
+                std::printf("[%12.6fs] dispatch key %3u %-6s -> ", record.time, record.input.keycode, record.flags & kRecordDispatchFailed ? "failed" : "ok");
+            } else if (record.flags & kRecordWindow) {
+                std::printf("[%12.6fs] attack window %-9s -> ", record.time, WindowEventName(record.input.keycode));
+            } else if (record.flags & kRecordRetry) {
+                std::printf("[%12.6fs] buffered retry          -> ", record.time);
+            } else if (record.flags & kRecordTick) {
+                std::printf("[%12.6fs] repeat                  -> ", record.time);
+            } else {
+                std::printf("[%12.6fs] key %3u %-4s held %6.3fs -> ", record.time, record.input.keycode, EdgeName(record.input), record.input.heldDownSecs);
+            }
+            PrintActions(actions.begin(), actions.end());
+            std::printf(" (decided in %u ns)", record.decisionNs);
+            if (!matches) {
+                std::printf(" MISMATCH, recorded: ");
+                PrintActions(record.actions.data(), record.actions.data() + record.actionCount);
+            }
+            std::printf("\n");
+        }
+    }
+
+    const auto inputCount = records.empty() ? 1 : records.size();
+    std::printf("\n%zu inputs, %zu actions, %zu mismatches\n", records.size(), actionCount, mismatches);
+    std::printf("undecided inputs: %zu behind a menu, %zu with the player not ready or controls disabled\n", menuBlocked, notReady);
+    std::printf("input buffer: %u hits, %u expired\n", stateMachine.GetBufferStats().hits, stateMachine.GetBufferStats().expired);
+    std::printf("recorded decision time: avg %.1f ns, max %u ns\n", static_cast<double>(recordedDecisionNs) / inputCount, recordedDecisionMaxNs);
+    std::printf("replay decision time: avg %.1f ns\n", static_cast<double>(replayTime.count()) / inputCount);
+    return mismatches == 0 ? 0 : 3;
+}